@@ -0,0 +1,427 @@
+// Times each phase of a hyq call on synthetic configs of configurable size:
+// path resolution, schema loading and registration, the hyprlang parse
+// with and without source=, query evaluation, the exporters and reading
+// config files.
+#include "ConfigGenerator.hpp"
+#include "ConfigScanner.hpp"
+#include "ConfigUtils.hpp"
+#include "FastPath.hpp"
+#include "InputFiles.hpp"
+#include "Output.hpp"
+#include "PathCache.hpp"
+#include "QueryEngine.hpp"
+#include "QueryFilter.hpp"
+#include "Schema.hpp"
+#include "SourceHandler.hpp"
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <regex>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+using namespace hyprquery;
+using namespace hyprquery::bench;
+
+namespace {
+
+struct Settings {
+  GeneratorOptions generator;
+  size_t runs = 15;
+  std::vector<size_t> schemaSizes;
+  std::vector<std::string> phases;
+  bool json = false;
+};
+
+class Reporter {
+public:
+  explicit Reporter(const Settings &settings) : m_settings(settings) {
+    if (!settings.json)
+      std::cout << fmt::format("{:<10} {:<34} {:>9} {:>12} {:>12}\n", "phase",
+                               "case", "ops", "median (us)", "min (us)");
+  }
+
+  // Time body over the configured runs; setup runs before each sample
+  // without being timed
+  void measure(const std::string &phase, const std::string &name,
+               size_t ops, const std::function<void()> &body,
+               const std::function<void()> &setup = {}) {
+    std::vector<double> samples;
+    for (size_t i = 0; i < m_settings.runs; ++i) {
+      if (setup)
+        setup();
+      auto start = std::chrono::steady_clock::now();
+      body();
+      samples.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+    }
+    std::sort(samples.begin(), samples.end());
+    double median = samples[samples.size() / 2];
+    if (m_settings.json) {
+      // One record per line, for comparing runs over time
+      const auto &gen = m_settings.generator;
+      nlohmann::json record = {
+          {"phase", phase},       {"case", name},
+          {"ops", ops},           {"median_us", median},
+          {"min_us", samples[0]}, {"keys", gen.keys},
+          {"variables", gen.variables}, {"depth", gen.depth},
+          {"fanout", gen.fanOut}, {"nesting", gen.nesting}};
+      std::cout << record.dump() << "\n";
+    } else {
+      std::cout << fmt::format("{:<10} {:<34} {:>9} {:>12.1f} {:>12.1f}\n",
+                               phase, name, ops, median, samples[0]);
+    }
+  }
+
+private:
+  const Settings &m_settings;
+};
+
+std::unique_ptr<Hyprlang::CConfig> emptyConfig() {
+  return std::make_unique<Hyprlang::CConfig>(
+      "", Hyprlang::SConfigOptions{.allowMissingConfig = true,
+                                   .pathIsStream = true});
+}
+
+// A schema with `count` INT options spread over a few categories
+std::string syntheticSchema(size_t count) {
+  nlohmann::json options = nlohmann::json::array();
+  for (size_t i = 0; i < count; ++i) {
+    options.push_back({{"value", fmt::format("cat{}:option_{}", i % 32, i)},
+                       {"type", "INT"},
+                       {"data", {{"default", i}, {"min", 0}, {"max", count}}}});
+  }
+  return nlohmann::json{{"hyprlang_schema", options}}.dump();
+}
+
+void benchPaths(Reporter &reporter, const GeneratedConfig &config) {
+  const std::pair<std::string, std::string> paths[] = {
+      {"normalizePath ~", "~/.config/hypr/hyprland.conf"},
+      {"normalizePath $HOME", "$HOME/.config/hypr/hyprland.conf"},
+      {"normalizePath quoted", "\"/etc/hypr/hyprland.conf\""},
+      {"normalizePath absolute", config.mainPath}};
+  for (const auto &[name, path] : paths) {
+    reporter.measure("paths", name, 1000, [&] {
+      for (int i = 0; i < 1000; ++i)
+        ConfigUtils::normalizePath(path);
+    });
+  }
+  reporter.measure("paths", "resolvePath main config", 1000, [&] {
+    for (int i = 0; i < 1000; ++i)
+      SourceHandler::resolvePath(config.mainPath);
+  });
+  // As inside one parse, where every lookup after the first is cached
+  reporter.measure("paths", "resolvePath main config, cached", 1000, [&] {
+    PathCache::Scope paths;
+    for (int i = 0; i < 1000; ++i)
+      SourceHandler::resolvePath(config.mainPath);
+  });
+  std::string glob = config.mainPath + ".d/*.conf";
+  reporter.measure("paths", "resolvePath source glob", 100, [&] {
+    for (int i = 0; i < 100; ++i)
+      SourceHandler::resolvePath(glob);
+  });
+}
+
+void benchSchema(Reporter &reporter, const Settings &settings) {
+  std::string error;
+  reporter.measure("schema", "load JSON (hyprland.json)", 1,
+                   [&] { Schema::load(HYQ_SCHEMA_JSON, error); });
+  auto json = Schema::load(HYQ_SCHEMA_JSON, error);
+  if (!json) {
+    std::cerr << "Error: " << error << std::endl;
+    return;
+  }
+  auto compiledPath = std::filesystem::temp_directory_path() /
+                      fmt::format("hyq-bench-{}.hqs", getpid());
+  std::ofstream(compiledPath, std::ios::binary) << json->compile();
+  reporter.measure("schema", "load compiled (.hqs)", 1,
+                   [&] { Schema::load(compiledPath.string(), error); });
+  reporter.measure("schema", "builtin", 1, [&] { Schema::builtin(); });
+  std::filesystem::remove(compiledPath);
+
+  // Full registration of every option against query-driven registration
+  auto registration = [&](const std::string &name, const Schema &schema,
+                          const std::string &queried) {
+    reporter.measure("register", name + " full", schema.size(), [&] {
+      auto config = emptyConfig();
+      ConfigUtils::addConfigValuesFromSchema(*config, schema);
+      config->commence();
+    });
+    reporter.measure("register", name + " lazy", 1, [&] {
+      auto config = emptyConfig();
+      ConfigUtils::addConfigValuesFromSchema(*config, schema, {queried});
+      config->commence();
+    });
+  };
+  registration("builtin", *Schema::builtin(), "general:border_size");
+  for (size_t size : settings.schemaSizes) {
+    auto schema = Schema::fromJson(syntheticSchema(size), error);
+    if (!schema) {
+      std::cerr << "Error: " << error << std::endl;
+      return;
+    }
+    registration(fmt::format("synthetic {}", size), *schema, "cat1:option_1");
+  }
+}
+
+EngineOptions engineOptions(const GeneratedConfig &config,
+                            bool followSource) {
+  EngineOptions options;
+  options.configPath = config.mainPath;
+  options.followSource = followSource;
+  return options;
+}
+
+void benchParse(Reporter &reporter, const GeneratedConfig &config) {
+  auto queries = parseQueryInputs(config.keys);
+  for (bool followSource : {false, true}) {
+    std::unique_ptr<QueryEngine> engine;
+    reporter.measure(
+        "parse", followSource ? "parse --source" : "parse main only",
+        followSource ? config.files : 1, [&] { engine->parse(); },
+        [&] {
+          engine = std::make_unique<QueryEngine>(
+              engineOptions(config, followSource));
+          engine->prepareConfig(queries);
+        });
+    // Without --source the source= lines themselves are errors
+    if (followSource && !engine->parseError().empty())
+      std::cerr << "Warning: " << engine->parseError() << std::endl;
+  }
+}
+
+// Reading every file of the tree through an ifstream line by line, as
+// hyprlang does, against mapping it; then the key scan of prepareConfig()
+// and a location lookup, each mapping the tree on its own or sharing one
+// mapping per file
+void benchInput(Reporter &reporter, const GeneratedConfig &config) {
+  std::vector<std::string> files;
+  for (const auto &entry : std::filesystem::recursive_directory_iterator(
+           std::filesystem::path(config.mainPath).parent_path())) {
+    if (entry.is_regular_file() && entry.path().extension() == ".conf")
+      files.push_back(entry.path().string());
+  }
+  std::string size = fmt::format("{:.1f} MiB", config.bytes / 1048576.0);
+  size_t lines = 0;
+  reporter.measure("input", "ifstream getline, " + size, files.size(), [&] {
+    std::string line;
+    for (const auto &path : files) {
+      std::ifstream in(path);
+      while (std::getline(in, line))
+        ++lines;
+    }
+  });
+  reporter.measure("input", "mapped memchr, " + size, files.size(), [&] {
+    for (const auto &path : files) {
+      auto file = InputFiles::map(path);
+      const char *at = file->data();
+      const char *end = at + file->size();
+      while (at < end) {
+        auto *newline = static_cast<const char *>(
+            memchr(at, '\n', static_cast<size_t>(end - at)));
+        at = newline ? newline + 1 : end;
+        ++lines;
+      }
+    }
+  });
+  auto scanTwice = [&] {
+    ConfigScanner::collectKeys(config.mainPath, true);
+    ConfigScanner::locateKeys(config.mainPath, true, {config.keys.back()});
+  };
+  reporter.measure("input", "scan twice, private mappings", files.size(),
+                   scanTwice);
+  reporter.measure("input", "scan twice, shared mappings", files.size(), [&] {
+    InputFiles::Scope inputs;
+    scanTwice();
+  });
+}
+
+void benchQueries(Reporter &reporter, const QueryEngine &engine,
+                  const GeneratedConfig &config) {
+  auto plain = parseQueryInputs(config.keys);
+  std::vector<std::string> typed;
+  std::vector<std::string> regex;
+  for (const auto &key : config.keys) {
+    typed.push_back(key + "[STRING]");
+    regex.push_back(key + "[STRING][\\d+]");
+  }
+  auto typedQueries = parseQueryInputs(typed);
+  auto regexQueries = parseQueryInputs(regex);
+  auto variables = parseQueryInputs(config.variables);
+
+  reporter.measure("query", "plain", plain.size(),
+                   [&] { engine.executeQueries(plain); });
+  reporter.measure("query", "type filter", typedQueries.size(),
+                   [&] { engine.executeQueries(typedQueries); });
+  reporter.measure("query", "type + regex filter", regexQueries.size(),
+                   [&] { engine.executeQueries(regexQueries); });
+  if (!variables.empty())
+    reporter.measure("query", "$variables", variables.size(),
+                     [&] { engine.executeQueries(variables); });
+}
+
+// Regex filters over every value: the std::regex built per query that hyq
+// used before, against the compiled and cached filters
+void benchFilters(Reporter &reporter, const std::vector<QueryResult> &results) {
+  for (const std::string pattern : {"1", "1.*", ".*5", ".*0.*", "\\d+",
+                                    "(0|1)+\\d*", "(\\d)\\1.*"}) {
+    reporter.measure("filter", fmt::format("std::regex /{}/", pattern),
+                     results.size(), [&] {
+                       for (const auto &result : results) {
+                         std::regex regex(pattern);
+                         std::string text = formatValue(result.value);
+                         std::regex_match(text, regex);
+                       }
+                     });
+    auto filter = QueryFilter::get("", pattern);
+    reporter.measure("filter",
+                     fmt::format("{} /{}/", filter->regex()->strategy(),
+                                 pattern),
+                     results.size(), [&] {
+                       for (const auto &result : results)
+                         filter->accepts(result.type,
+                                         ValueText(result.value));
+                     });
+  }
+}
+
+void benchExport(Reporter &reporter, const std::vector<QueryResult> &results) {
+  // Number text: std::to_string into a new string, as hyq formatted values
+  // before, against the shortest round-trip form in an inline buffer
+  std::vector<Value> numbers;
+  for (size_t i = 0; i < results.size(); ++i)
+    numbers.push_back(i % 2 ? Value(int64_t(i)) : Value(double(i) / 7));
+  size_t length = 0;
+  reporter.measure("export", "std::to_string numbers", numbers.size(), [&] {
+    for (const auto &value : numbers) {
+      if (auto *integer = std::get_if<int64_t>(&value))
+        length += std::to_string(*integer).size();
+      else
+        length += std::to_string(std::get<double>(value)).size();
+    }
+  });
+  reporter.measure("export", "ValueText numbers", numbers.size(), [&] {
+    for (const auto &value : numbers)
+      length += ValueText(value).view().size();
+  });
+  for (const std::string format : {"json", "ndjson", "env", "plain"}) {
+    std::string bytes;
+    reporter.measure("export", format, results.size(), [&] {
+      bytes.clear();
+      OutputWriter out(bytes);
+      outputResults(out, results, format == "plain" ? "" : format, "\n");
+    });
+  }
+}
+
+void benchFastPath(Reporter &reporter, const GeneratedConfig &config) {
+  // One query that the scanner answers, the common case it is for
+  std::string key;
+  for (size_t i = 0; i < config.keys.size() && key.empty(); ++i) {
+    if (FastPath::run(engineOptions(config, false),
+                      parseQueryInputs({config.keys[i]})))
+      key = config.keys[i];
+  }
+  if (key.empty())
+    return;
+  auto queries = parseQueryInputs({key});
+  reporter.measure("fastpath", "raw scan, one key", 1, [&] {
+    FastPath::run(engineOptions(config, false), queries);
+  });
+  reporter.measure("fastpath", "full parse, one key", 1, [&] {
+    auto options = engineOptions(config, false);
+    options.fastPath = false;
+    QueryEngine engine(options);
+    engine.prepareConfig(queries);
+    engine.parse();
+    engine.executeQueries(queries);
+  });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  CLI::App app{"hyq_bench - phase timings on synthetic configs"};
+  Settings settings;
+  std::string dir = (std::filesystem::temp_directory_path() /
+                     fmt::format("hyq-bench-{}", getpid()))
+                        .string();
+  bool keep = false;
+  app.add_option("--keys", settings.generator.keys,
+                 "Assignments in the generated config");
+  app.add_option("--variables", settings.generator.variables,
+                 "Variables defined in the main config");
+  app.add_option("--depth", settings.generator.depth,
+                 "Levels of nested source= globs");
+  app.add_option("--fanout", settings.generator.fanOut,
+                 "Files each source= glob matches");
+  app.add_option("--nesting", settings.generator.nesting,
+                 "Levels of categories around each group of keys");
+  app.add_option("--runs", settings.runs, "Samples per measurement");
+  app.add_option("--schema-sizes", settings.schemaSizes,
+                 "Synthetic schema sizes for the registration phase");
+  app.add_option("--phase", settings.phases,
+                 "Only run these phases: paths, schema, parse, query, filter, "
+                 "export, fastpath, input");
+  app.add_option("--dir", dir, "Where to generate the config");
+  app.add_flag("--keep", keep, "Keep the generated config");
+  app.add_flag("--json", settings.json,
+               "Write one JSON record per measurement");
+  CLI11_PARSE(app, argc, argv);
+  spdlog::set_level(spdlog::level::off);
+  if (settings.schemaSizes.empty())
+    settings.schemaSizes = {1000, 10000, 100000};
+  if (settings.runs == 0)
+    settings.runs = 1;
+
+  auto config = generateConfig(dir, settings.generator);
+  if (!settings.json)
+    std::cout << fmt::format("Generated {} keys, {} variables in {} files "
+                             "({} bytes) under {}\n\n",
+                             config.keys.size(), config.variables.size(),
+                             config.files, config.bytes, dir);
+
+  auto enabled = [&](const std::string &phase) {
+    return settings.phases.empty() ||
+           std::find(settings.phases.begin(), settings.phases.end(),
+                     phase) != settings.phases.end();
+  };
+  Reporter reporter(settings);
+  if (enabled("paths"))
+    benchPaths(reporter, config);
+  if (enabled("schema"))
+    benchSchema(reporter, settings);
+  if (enabled("parse"))
+    benchParse(reporter, config);
+  if (enabled("input"))
+    benchInput(reporter, config);
+  if (enabled("query") || enabled("filter") || enabled("export")) {
+    auto queries = parseQueryInputs(config.keys);
+    QueryEngine engine(engineOptions(config, true));
+    engine.prepareConfig(queries);
+    engine.parse();
+    if (enabled("query"))
+      benchQueries(reporter, engine, config);
+    auto results = engine.executeQueries(queries);
+    if (enabled("filter"))
+      benchFilters(reporter, results);
+    if (enabled("export"))
+      benchExport(reporter, results);
+  }
+
+  if (enabled("fastpath"))
+    benchFastPath(reporter, config);
+
+  if (!keep)
+    std::filesystem::remove_all(dir);
+  return 0;
+}
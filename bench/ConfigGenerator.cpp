@@ -0,0 +1,110 @@
+#include "ConfigGenerator.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <spdlog/fmt/fmt.h>
+
+namespace hyprquery::bench {
+
+namespace {
+
+constexpr size_t KEYS_PER_CATEGORY = 16;
+
+class TreeWriter {
+public:
+  TreeWriter(const GeneratorOptions &options, GeneratedConfig &out)
+      : m_options(options), m_out(out) {
+    // Every level multiplies the file count by the fan-out
+    size_t files = 1;
+    size_t level = 1;
+    for (size_t i = 0; i < options.depth; ++i) {
+      level *= options.fanOut;
+      files += level;
+    }
+    m_keysPerFile = options.keys / files;
+    m_extraKeys = options.keys % files;
+  }
+
+  void write(const std::filesystem::path &path, size_t level) {
+    std::string text;
+    if (level == 0) {
+      for (size_t i = 0; i < m_options.variables; ++i) {
+        std::string name = fmt::format("var_{}", i);
+        text += fmt::format("${} = {}\n", name, i * 7);
+        m_out.variables.push_back("$" + name);
+      }
+      text += '\n';
+    }
+
+    size_t count = m_keysPerFile + (level == 0 ? m_extraKeys : 0);
+    for (size_t i = 0; i < count; i += KEYS_PER_CATEGORY) {
+      std::string category =
+          fmt::format("cat_{}", m_nextKey / KEYS_PER_CATEGORY);
+      text += category + " {\n";
+      const size_t nesting = std::max<size_t>(m_options.nesting, 1);
+      std::string indent = "    ";
+      for (size_t level = 1; level < nesting; ++level) {
+        std::string inner = fmt::format("sub_{}", level);
+        category += ":" + inner;
+        text += indent + inner + " {\n";
+        indent += "    ";
+      }
+      for (size_t j = i; j < count && j < i + KEYS_PER_CATEGORY; ++j) {
+        size_t index = m_nextKey++;
+        std::string name = fmt::format("key_{}", index);
+        m_out.keys.push_back(category + ":" + name);
+        if (m_options.variables > 0 && index % 8 == 0)
+          text += fmt::format("{}{} = $var_{}\n", indent, name,
+                              index % m_options.variables);
+        else if (index % 3 == 0)
+          text += fmt::format("{}{} = rgba({:08x})\n", indent, name, index);
+        else
+          text += fmt::format("{}{} = {}\n", indent, name, index);
+      }
+      for (size_t level = nesting; level-- > 0;)
+        text += std::string(level * 4, ' ') + "}\n";
+    }
+
+    if (level < m_options.depth && m_options.fanOut > 0) {
+      auto subdir = path.parent_path() / (path.filename().string() + ".d");
+      std::filesystem::create_directories(subdir);
+      text += fmt::format("\nsource = ./{}.d/*.conf\n",
+                          path.filename().string());
+      // Children are written after the parent's keys were numbered, so
+      // key order is parse order
+      std::ofstream(path) << text;
+      account(text);
+      for (size_t i = 0; i < m_options.fanOut; ++i)
+        write(subdir / fmt::format("part_{:04}.conf", i), level + 1);
+      return;
+    }
+    std::ofstream(path) << text;
+    account(text);
+  }
+
+private:
+  void account(const std::string &text) {
+    ++m_out.files;
+    m_out.bytes += text.size();
+  }
+
+  const GeneratorOptions &m_options;
+  GeneratedConfig &m_out;
+  size_t m_keysPerFile = 0;
+  size_t m_extraKeys = 0;
+  size_t m_nextKey = 0;
+};
+
+} // namespace
+
+GeneratedConfig generateConfig(const std::string &dir,
+                               const GeneratorOptions &options) {
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  GeneratedConfig out;
+  out.mainPath = (std::filesystem::path(dir) / "hyprland.conf").string();
+  TreeWriter(options, out).write(out.mainPath, 0);
+  return out;
+}
+
+} // namespace hyprquery::bench
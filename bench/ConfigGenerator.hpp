@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace hyprquery::bench {
+
+struct GeneratorOptions {
+  // Assignments over all files, spread evenly
+  size_t keys = 1000;
+  // Variables defined in the main config and used by every eighth value
+  size_t variables = 64;
+  // Levels of nested `source = ./<file>.d/*.conf` below the main config
+  size_t depth = 0;
+  // Files each of those globs matches
+  size_t fanOut = 1;
+  // Levels of categories around each group of keys, cat_N:sub_1:...:key_M
+  size_t nesting = 1;
+};
+
+struct GeneratedConfig {
+  std::string mainPath;
+  // Every assigned key, in the order the parse visits them
+  std::vector<std::string> keys;
+  std::vector<std::string> variables;
+  size_t files = 0;
+  size_t bytes = 0;
+};
+
+// Write a synthetic hyprlang config tree below dir, replacing what is
+// there
+GeneratedConfig generateConfig(const std::string &dir,
+                               const GeneratorOptions &options);
+
+} // namespace hyprquery::bench
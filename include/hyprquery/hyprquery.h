@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+ * libhyprquery - query hypr* config files in-process.
+ *
+ * A handle owns one parsed config. Handles are independent of each other
+ * and may be used from different threads at the same time; a single handle
+ * must only be used by one thread at a time.
+ *
+ * Queries use the hyq syntax: "key", "key[TYPE][regex]", "$VARIABLE" and
+ * wildcard patterns such as "general:*", which yield one result per match.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped with the library SOVERSION on every incompatible ABI change */
+#define HYQ_API_VERSION 1
+
+#define HYQ_EXPORT __attribute__((visibility("default")))
+
+typedef struct hyq_config hyq_config;
+typedef struct hyq_results hyq_results;
+
+/* Flags for hyq_open */
+enum {
+  /* Follow source= lines */
+  HYQ_OPEN_FOLLOW_SOURCE = 1u << 0,
+  /* Use the Hyprland schema built into the library */
+  HYQ_OPEN_BUILTIN_SCHEMA = 1u << 1,
+  /* Register only the schema options that are queried */
+  HYQ_OPEN_LAZY_SCHEMA = 1u << 2,
+};
+
+typedef enum hyq_type {
+  HYQ_TYPE_NULL = 0,
+  HYQ_TYPE_INT,
+  HYQ_TYPE_FLOAT,
+  HYQ_TYPE_STRING,
+  HYQ_TYPE_VEC2,
+  HYQ_TYPE_CUSTOM,
+  /* Every value of a repeated keyword like bind, one per line in text */
+  HYQ_TYPE_LIST,
+} hyq_type;
+
+/* One result; strings stay valid until the owning hyq_results is freed.
+ * A filter that does not match or a missing key gives HYQ_TYPE_NULL. */
+typedef struct hyq_value {
+  const char *key;
+  hyq_type type;
+  /* The value as hyq prints it, for every type */
+  const char *text;
+  /* HYQ_TYPE_INT */
+  int64_t int_value;
+  /* HYQ_TYPE_FLOAT, and the components of HYQ_TYPE_VEC2 */
+  double float_value;
+  double vec2[2];
+} hyq_value;
+
+/* Open and parse a config. schema_path may be NULL. Returns NULL and sets
+ * hyq_last_error() if the config can not be resolved; parse errors inside
+ * the config are reported by hyq_parse_error() instead. */
+HYQ_EXPORT hyq_config *hyq_open(const char *config_path,
+                                const char *schema_path, unsigned flags);
+
+/* Parse again if the config or any sourced file changed, in place when only
+ * sourced leaf files changed. Returns 0, or -1 and sets hyq_last_error(). */
+HYQ_EXPORT int hyq_reload(hyq_config *config);
+
+/* Last parse error of the config, NULL if it parsed cleanly */
+HYQ_EXPORT const char *hyq_parse_error(const hyq_config *config);
+
+HYQ_EXPORT void hyq_close(hyq_config *config);
+
+/* Answer count queries. Keys that were never queried before are
+ * registered by parsing the config again. Returns NULL and sets
+ * hyq_last_error() on failure. */
+HYQ_EXPORT hyq_results *hyq_query(hyq_config *config,
+                                  const char *const *queries, size_t count);
+
+HYQ_EXPORT size_t hyq_results_size(const hyq_results *results);
+HYQ_EXPORT const hyq_value *hyq_results_at(const hyq_results *results,
+                                           size_t index);
+HYQ_EXPORT void hyq_results_free(hyq_results *results);
+
+/* Message for the last failed call on this thread */
+HYQ_EXPORT const char *hyq_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
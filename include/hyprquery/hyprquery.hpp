@@ -0,0 +1,91 @@
+#pragma once
+
+// Header-only C++ interface to libhyprquery. It wraps the C ABI, so it
+// keeps working across library updates without a rebuild.
+
+#include "hyprquery.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace hyprquery {
+
+struct Value {
+  std::string key;
+  hyq_type type = HYQ_TYPE_NULL;
+  std::string text;
+  int64_t intValue = 0;
+  double floatValue = 0;
+  std::array<double, 2> vec2{};
+
+  bool isNull() const { return type == HYQ_TYPE_NULL; }
+};
+
+class Error : public std::runtime_error {
+public:
+  Error() : std::runtime_error(hyq_last_error()) {}
+};
+
+// One parsed config; see hyprquery.h for the threading rules
+class Config {
+public:
+  explicit Config(const std::string &configPath,
+                  const std::string &schemaPath = {},
+                  unsigned flags = HYQ_OPEN_FOLLOW_SOURCE)
+      : m_handle(hyq_open(configPath.c_str(),
+                          schemaPath.empty() ? nullptr : schemaPath.c_str(),
+                          flags),
+                 hyq_close) {
+    if (!m_handle)
+      throw Error();
+  }
+
+  std::vector<Value> query(const std::vector<std::string> &queries) {
+    std::vector<const char *> raw;
+    raw.reserve(queries.size());
+    for (const auto &query : queries)
+      raw.push_back(query.c_str());
+    std::unique_ptr<hyq_results, decltype(&hyq_results_free)> results(
+        hyq_query(m_handle.get(), raw.data(), raw.size()), hyq_results_free);
+    if (!results)
+      throw Error();
+
+    std::vector<Value> values;
+    values.reserve(hyq_results_size(results.get()));
+    for (size_t i = 0; i < hyq_results_size(results.get()); ++i) {
+      const hyq_value *value = hyq_results_at(results.get(), i);
+      values.push_back({value->key, value->type, value->text,
+                        value->int_value, value->float_value,
+                        {value->vec2[0], value->vec2[1]}});
+    }
+    return values;
+  }
+
+  // The first result of a single query
+  Value query(const std::string &query) {
+    auto values = this->query(std::vector<std::string>{query});
+    return values.empty() ? Value{query} : std::move(values.front());
+  }
+
+  void reload() {
+    if (hyq_reload(m_handle.get()) != 0)
+      throw Error();
+  }
+
+  std::optional<std::string> parseError() const {
+    const char *error = hyq_parse_error(m_handle.get());
+    return error ? std::optional<std::string>(error) : std::nullopt;
+  }
+
+  hyq_config *handle() const { return m_handle.get(); }
+
+private:
+  std::unique_ptr<hyq_config, decltype(&hyq_close)> m_handle;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,136 @@
+#include "BatchMode.hpp"
+#include "InputFiles.hpp"
+#include "Io.hpp"
+#include <cerrno>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <string_view>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace hyprquery {
+
+namespace {
+
+std::string_view trim(std::string_view str) {
+  size_t start = str.find_first_not_of(" \t\r");
+  if (start == std::string_view::npos)
+    return {};
+  size_t end = str.find_last_not_of(" \t\r");
+  return str.substr(start, end - start + 1);
+}
+
+} // namespace
+
+int runBatch(const EngineOptions &options, bool strictMode, int inputFd,
+             int outputFd) {
+  // Every key the config assigns or the schema lists is registered by the
+  // first parse, so only keys outside both cost a rebuild. With
+  // --lazy-schema that registers the whole schema once for the stream.
+  std::vector<std::string> keys = {"*"};
+  std::unordered_set<std::string> keySet(keys.begin(), keys.end());
+  auto build = [&]() {
+    InputFiles::Scope inputs;
+    auto engine = std::make_unique<QueryEngine>(options);
+    engine->prepareConfig({}, keys);
+    engine->parse();
+    if (!engine->parseError().empty())
+      spdlog::debug("[batch] Parse error: {}", engine->parseError());
+    return engine;
+  };
+  auto engine = build();
+  if (strictMode && !engine->parseError().empty())
+    return 1;
+
+  std::string input;
+  std::string output;
+  char chunk[65536];
+  size_t consumed = 0;
+  bool eof = false;
+  while (true) {
+    size_t newline;
+    while ((newline = input.find('\n', consumed)) != std::string::npos) {
+      std::string_view line =
+          trim(std::string_view(input).substr(consumed, newline - consumed));
+      consumed = newline + 1;
+      if (line.empty())
+        continue;
+
+      nlohmann::json record;
+      std::string rawQuery;
+      if (line.front() == '{' || line.front() == '"') {
+        auto parsed = nlohmann::json::parse(line, nullptr, false);
+        if (parsed.is_string()) {
+          rawQuery = parsed.get<std::string>();
+        } else if (parsed.is_object() && parsed.contains("query") &&
+                   parsed["query"].is_string()) {
+          rawQuery = parsed["query"].get<std::string>();
+          if (parsed.contains("id"))
+            record["id"] = parsed["id"];
+        } else {
+          record["error"] = "expected a query string or an object with a "
+                            "\"query\" string";
+          output += record.dump();
+          output += '\n';
+          continue;
+        }
+      } else {
+        rawQuery = line;
+      }
+
+      std::vector<QueryInput> queries;
+      try {
+        queries = parseQueryInputs({rawQuery});
+      } catch (const std::invalid_argument &e) {
+        record["error"] = e.what();
+        output += record.dump();
+        output += '\n';
+        continue;
+      }
+      if (!engine->covers(queries)) {
+        for (const auto &q : queries) {
+          if (keySet.insert(q.query).second)
+            keys.push_back(q.query);
+        }
+        spdlog::debug("[batch] Registering {}, reparsing", rawQuery);
+        engine = build();
+      }
+      for (const auto &result : engine->executeQueries(queries)) {
+        record["key"] = result.key;
+        record["val"] = toJson(result.value);
+        record["type"] = result.type;
+        record["flags"] = result.flags;
+        output += record.dump();
+        output += '\n';
+      }
+    }
+    input.erase(0, consumed);
+    consumed = 0;
+
+    // Everything that was already buffered is answered; flush before
+    // blocking so a coprocess gets its answer right away
+    if (!output.empty()) {
+      if (!writeAll(outputFd, output))
+        return 1;
+      output.clear();
+    }
+
+    if (eof)
+      break;
+    ssize_t n = read(inputFd, chunk, sizeof(chunk));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      // Answer a last line that is not newline terminated
+      eof = true;
+      if (!input.empty())
+        input += '\n';
+      continue;
+    }
+    input.append(chunk, static_cast<size_t>(n));
+  }
+  return 0;
+}
+
+} // namespace hyprquery
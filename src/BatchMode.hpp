@@ -0,0 +1,10 @@
+#pragma once
+#include "QueryEngine.hpp"
+
+namespace hyprquery {
+// Parse the config once, then answer one query per input line and write one
+// NDJSON record per query. Lines are JSON strings, objects with a "query"
+// member (and an optional "id" that is echoed back) or raw query text.
+int runBatch(const EngineOptions &options, bool strictMode, int inputFd,
+             int outputFd);
+} // namespace hyprquery
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace hyprquery {
+
+// FNV-1a, used for cache file names and option fingerprints
+constexpr uint64_t fnv1a(std::string_view data,
+                         uint64_t seed = 0xcbf29ce484222325ULL) {
+  uint64_t hash = seed;
+  for (char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Appends fixed-width values and length-prefixed strings to a byte buffer
+class ByteWriter {
+public:
+  template <typename T> void put(T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    m_buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void putString(std::string_view str) {
+    put<uint32_t>(static_cast<uint32_t>(str.size()));
+    m_buffer.append(str);
+  }
+
+  template <typename T> void patch(size_t offset, T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    std::memcpy(m_buffer.data() + offset, &value, sizeof(T));
+  }
+
+  size_t size() const { return m_buffer.size(); }
+  const std::string &buffer() const { return m_buffer; }
+
+private:
+  std::string m_buffer;
+};
+
+// Bounds-checked cursor over a byte buffer written by ByteWriter. Strings are
+// returned as views into the underlying buffer.
+class ByteReader {
+public:
+  explicit ByteReader(std::string_view data) : m_data(data) {}
+
+  template <typename T> bool get(T &value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (!m_ok || m_data.size() - m_offset < sizeof(T))
+      return m_ok = false;
+    std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+    m_offset += sizeof(T);
+    return true;
+  }
+
+  bool getString(std::string_view &str) {
+    uint32_t len = 0;
+    if (!get(len) || m_data.size() - m_offset < len)
+      return m_ok = false;
+    str = m_data.substr(m_offset, len);
+    m_offset += len;
+    return true;
+  }
+
+  bool seek(size_t offset) {
+    if (offset > m_data.size())
+      return m_ok = false;
+    m_offset = offset;
+    return m_ok;
+  }
+
+  bool ok() const { return m_ok; }
+  size_t offset() const { return m_offset; }
+
+private:
+  std::string_view m_data;
+  size_t m_offset = 0;
+  bool m_ok = true;
+};
+
+} // namespace hyprquery
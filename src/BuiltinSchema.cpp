@@ -0,0 +1,14 @@
+#include "BuiltinSchema.hpp"
+
+namespace hyprquery {
+
+std::unique_ptr<Schema> Schema::builtin() {
+  auto schema = std::make_unique<Schema>();
+  schema->m_optionView = builtin_schema::options();
+  schema->m_choiceView = builtin_schema::choices();
+  schema->m_displacementView = builtin_schema::displacements();
+  schema->m_slotView = builtin_schema::slots();
+  return schema;
+}
+
+} // namespace hyprquery
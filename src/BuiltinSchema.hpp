@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Schema.hpp"
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// Tables generated from schema/hyprland.json by hyq-schemagen
+namespace hyprquery::builtin_schema {
+
+// FNV-1a of the JSON the tables were generated from
+extern const uint64_t SOURCE_HASH;
+
+std::span<const SchemaOption> options();
+std::span<const std::string_view> choices();
+std::span<const int32_t> displacements();
+std::span<const uint32_t> slots();
+
+} // namespace hyprquery::builtin_schema
@@ -0,0 +1,166 @@
+#include "Color.hpp"
+#include <charconv>
+#include <cmath>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr char HEX[] = "0123456789abcdef";
+
+std::string_view trim(std::string_view text) {
+  size_t start = text.find_first_not_of(" \t");
+  if (start == std::string_view::npos)
+    return {};
+  return text.substr(start, text.find_last_not_of(" \t") - start + 1);
+}
+
+std::optional<uint32_t> parseHex(std::string_view digits) {
+  uint32_t value = 0;
+  auto [end, ec] = std::from_chars(digits.data(),
+                                   digits.data() + digits.size(), value, 16);
+  if (digits.empty() || ec != std::errc() ||
+      end != digits.data() + digits.size())
+    return std::nullopt;
+  return value;
+}
+
+// r, g, b and, when alpha is expected, a in [0, 1]
+std::optional<uint32_t> parseDecimal(std::string_view args, bool alpha) {
+  uint32_t channels[4] = {0, 0, 0, 255};
+  size_t count = alpha ? 4 : 3;
+  for (size_t i = 0; i < count; ++i) {
+    size_t comma = args.find(',');
+    if ((comma == std::string_view::npos) != (i + 1 == count))
+      return std::nullopt;
+    std::string_view part = trim(args.substr(0, comma));
+    args.remove_prefix(comma == std::string_view::npos ? args.size()
+                                                       : comma + 1);
+    double number = 0;
+    auto [end, ec] =
+        std::from_chars(part.data(), part.data() + part.size(), number);
+    if (part.empty() || ec != std::errc() ||
+        end != part.data() + part.size())
+      return std::nullopt;
+    if (i == 3)
+      number *= 255;
+    if (!(number >= 0 && number <= 255))
+      return std::nullopt;
+    channels[i] = static_cast<uint32_t>(std::lround(number));
+  }
+  return channels[3] << 24 | channels[0] << 16 | channels[1] << 8 |
+         channels[2];
+}
+
+// The argument list of name(...), if text is a call of it
+std::optional<std::string_view> arguments(std::string_view text,
+                                          std::string_view name) {
+  if (!text.starts_with(name) || text.size() < name.size() + 2 ||
+      text[name.size()] != '(' || text.back() != ')')
+    return std::nullopt;
+  return text.substr(name.size() + 1, text.size() - name.size() - 2);
+}
+
+} // namespace
+
+std::optional<uint32_t> parseColor(std::string_view text) {
+  text = trim(text);
+  if (auto args = arguments(text, "rgba")) {
+    if (args->size() == 8 && args->find(',') == std::string_view::npos) {
+      // RRGGBBAA
+      auto value = parseHex(*args);
+      if (!value)
+        return std::nullopt;
+      return (*value & 0xff) << 24 | *value >> 8;
+    }
+    return parseDecimal(*args, true);
+  }
+  if (auto args = arguments(text, "rgb")) {
+    if (args->size() == 6 && args->find(',') == std::string_view::npos) {
+      auto value = parseHex(*args);
+      if (!value)
+        return std::nullopt;
+      return 0xff000000u | *value;
+    }
+    return parseDecimal(*args, false);
+  }
+  if (text.starts_with("0x") && text.size() <= 10)
+    return parseHex(text.substr(2));
+  return std::nullopt;
+}
+
+std::optional<Gradient> parseGradient(std::string_view text) {
+  Gradient gradient;
+  text = trim(text);
+  while (!text.empty()) {
+    // Whitespace inside rgba(...) does not end a color
+    size_t end = 0;
+    for (int depth = 0; end < text.size(); ++end) {
+      char c = text[end];
+      if (c == '(')
+        ++depth;
+      else if (c == ')')
+        --depth;
+      else if ((c == ' ' || c == '\t') && depth == 0)
+        break;
+    }
+    std::string_view token = text.substr(0, end);
+    text = trim(text.substr(end));
+
+    if (token.ends_with("deg")) {
+      // The angle comes last
+      std::string_view number = token.substr(0, token.size() - 3);
+      auto [stop, ec] = std::from_chars(
+          number.data(), number.data() + number.size(), gradient.angle);
+      if (!text.empty() || gradient.count == 0 || number.empty() ||
+          ec != std::errc() || stop != number.data() + number.size())
+        return std::nullopt;
+      gradient.hasAngle = true;
+      break;
+    }
+    auto color = parseColor(token);
+    if (!color || gradient.count == Gradient::MAX_STOPS)
+      return std::nullopt;
+    gradient.stops[gradient.count++] = *color;
+  }
+  if (gradient.count == 0)
+    return std::nullopt;
+  return gradient;
+}
+
+std::optional<ColorFormat> colorFormatFromString(std::string_view name) {
+  if (name == "hex")
+    return ColorFormat::Hex;
+  if (name == "hexa")
+    return ColorFormat::HexAlpha;
+  if (name == "rgba")
+    return ColorFormat::Rgba;
+  if (name == "int")
+    return ColorFormat::Int;
+  if (name == "json")
+    return ColorFormat::Json;
+  return std::nullopt;
+}
+
+char *formatColor(char *out, uint32_t color, ColorFormat format) {
+  uint8_t channels[4] = {
+      static_cast<uint8_t>(color >> 16), static_cast<uint8_t>(color >> 8),
+      static_cast<uint8_t>(color), static_cast<uint8_t>(color >> 24)};
+  if (format == ColorFormat::Rgba) {
+    for (size_t i = 0; i < 4; ++i) {
+      if (i > 0)
+        *out++ = ',';
+      out = std::to_chars(out, out + 3, unsigned(channels[i])).ptr;
+    }
+    return out;
+  }
+  *out++ = '#';
+  size_t count = format == ColorFormat::Hex ? 3 : 4;
+  for (size_t i = 0; i < count; ++i) {
+    *out++ = HEX[channels[i] >> 4];
+    *out++ = HEX[channels[i] & 0xf];
+  }
+  return out;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace hyprquery {
+
+// A color or gradient value in hyprland's syntax. Colors are packed as
+// 0xAARRGGBB, like hyprland keeps them.
+struct Gradient {
+  // hyprland's own limit
+  static constexpr size_t MAX_STOPS = 10;
+
+  uint32_t stops[MAX_STOPS] = {};
+  uint8_t count = 0;
+  // Degrees
+  double angle = 0;
+  bool hasAngle = false;
+
+  // One color and no angle, as a COLOR option holds
+  bool isColor() const { return count == 1 && !hasAngle; }
+  bool operator==(const Gradient &) const = default;
+};
+
+// rgba(RRGGBBAA), rgba(r, g, b, a) with a in [0, 1], rgb(RRGGBB),
+// rgb(r, g, b) or 0xAARRGGBB
+std::optional<uint32_t> parseColor(std::string_view text);
+
+// Colors separated by whitespace, optionally followed by an angle such as
+// 45deg
+std::optional<Gradient> parseGradient(std::string_view text);
+
+// How a `key|format` query prints colors
+enum class ColorFormat : uint8_t {
+  None,
+  // #rrggbb
+  Hex,
+  // #rrggbbaa
+  HexAlpha,
+  // r,g,b,a with every channel in [0, 255]
+  Rgba,
+  // The packed 0xAARRGGBB value as an INT
+  Int,
+  // {"angle": ..., "stops": ["#rrggbbaa", ...]}
+  Json,
+};
+
+std::optional<ColorFormat> colorFormatFromString(std::string_view name);
+
+// Format one color into out, which must hold 16 characters; returns the end
+char *formatColor(char *out, uint32_t color, ColorFormat format);
+
+} // namespace hyprquery
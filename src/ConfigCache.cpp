@@ -0,0 +1,362 @@
+#include "ConfigCache.hpp"
+#include "BinaryIO.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr uint32_t SNAPSHOT_MAGIC = 0x53515948; // "HYQS"
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+// Values are stored as their variant index and native payload. Keyword
+// lists are never stored, queries for them always parse.
+void putValue(ByteWriter &writer, const Value &value) {
+  writer.put<uint8_t>(value.index());
+  if (auto *integer = std::get_if<int64_t>(&value)) {
+    writer.put(*integer);
+  } else if (auto *real = std::get_if<double>(&value)) {
+    writer.put(*real);
+  } else if (auto *vec = std::get_if<Vec2>(&value)) {
+    writer.put(vec->x);
+    writer.put(vec->y);
+  } else if (auto *text = std::get_if<std::string>(&value)) {
+    writer.putString(*text);
+  } else if (auto *gradient = std::get_if<Gradient>(&value)) {
+    writer.put(gradient->count);
+    for (size_t i = 0; i < gradient->count; ++i)
+      writer.put(gradient->stops[i]);
+    writer.put(gradient->angle);
+    writer.put<uint8_t>(gradient->hasAngle);
+  }
+}
+
+bool getValue(ByteReader &reader, Value &value) {
+  uint8_t index = 0;
+  if (!reader.get(index))
+    return false;
+  switch (index) {
+  case 0:
+    value = {};
+    return true;
+  case 1: {
+    int64_t integer = 0;
+    reader.get(integer);
+    value = integer;
+    break;
+  }
+  case 2: {
+    double real = 0;
+    reader.get(real);
+    value = real;
+    break;
+  }
+  case 3: {
+    Vec2 vec;
+    reader.get(vec.x);
+    reader.get(vec.y);
+    value = vec;
+    break;
+  }
+  case 4: {
+    std::string_view text;
+    reader.getString(text);
+    value = std::string(text);
+    break;
+  }
+  case 5: {
+    Gradient gradient;
+    reader.get(gradient.count);
+    if (gradient.count > Gradient::MAX_STOPS)
+      return false;
+    for (size_t i = 0; i < gradient.count; ++i)
+      reader.get(gradient.stops[i]);
+    reader.get(gradient.angle);
+    uint8_t hasAngle = 0;
+    reader.get(hasAngle);
+    gradient.hasAngle = hasAngle;
+    value = gradient;
+    break;
+  }
+  default:
+    return false;
+  }
+  return reader.ok();
+}
+
+bool isNameStart(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isNameChar(char c) { return isNameStart(c) || (c >= '0' && c <= '9'); }
+
+std::string cacheDirectory() {
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  if (xdg && *xdg)
+    return std::string(xdg) + "/hyprquery";
+  const char *home = getenv("HOME");
+  if (home && *home)
+    return std::string(home) + "/.cache/hyprquery";
+  return "/tmp/hyprquery-" + std::to_string(getuid());
+}
+
+} // namespace
+
+FileStamp FileStamp::capture(const std::string &path) {
+  struct stat st;
+  return fromStat(path, stat(path.c_str(), &st) == 0 ? &st : nullptr);
+}
+
+FileStamp FileStamp::fromStat(const std::string &path, const struct stat *st) {
+  FileStamp stamp;
+  stamp.path = path;
+  if (!st)
+    return stamp;
+  stamp.kind = S_ISDIR(st->st_mode) ? Kind::Directory : Kind::File;
+  stamp.device = st->st_dev;
+  stamp.inode = st->st_ino;
+  stamp.mtimeNs = static_cast<int64_t>(st->st_mtim.tv_sec) * 1000000000 +
+                  st->st_mtim.tv_nsec;
+  stamp.size = static_cast<uint64_t>(st->st_size);
+  return stamp;
+}
+
+bool FileStamp::matches(const FileStamp &other) const {
+  return kind == other.kind && device == other.device &&
+         inode == other.inode && mtimeNs == other.mtimeNs &&
+         size == other.size;
+}
+
+ConfigCache::ConfigCache(std::string snapshotPath, uint64_t fingerprint)
+    : m_snapshotPath(std::move(snapshotPath)), m_fingerprint(fingerprint) {}
+
+std::string ConfigCache::defaultSnapshotPath(const std::string &configPath,
+                                             const std::string &schemaPath,
+                                             uint64_t fingerprint) {
+  uint64_t hash = fnv1a(configPath);
+  hash = fnv1a(std::string_view("\0", 1), hash);
+  hash = fnv1a(schemaPath, hash);
+  return fmt::format("{}/{:016x}-{:016x}.hqc", cacheDirectory(), hash,
+                     fingerprint);
+}
+
+void ConfigCache::collectEnvReferences(std::string_view text,
+                                       std::vector<std::string> &names) {
+  size_t pos = 0;
+  while ((pos = text.find('$', pos)) != std::string_view::npos) {
+    size_t start = ++pos;
+    if (start >= text.size() || !isNameStart(text[start]))
+      continue;
+    while (pos < text.size() && isNameChar(text[pos]))
+      ++pos;
+    std::string name(text.substr(start, pos - start));
+    if (std::find(names.begin(), names.end(), name) == names.end())
+      names.push_back(std::move(name));
+  }
+}
+
+bool ConfigCache::open() {
+  m_file = MappedFile(m_snapshotPath);
+  if (!m_file.isOpen()) {
+    m_staleReason = "no snapshot";
+    return false;
+  }
+
+  ByteReader reader(m_file.view());
+  uint32_t magic = 0, version = 0;
+  uint64_t fingerprint = 0;
+  if (!reader.get(magic) || !reader.get(version) || !reader.get(fingerprint) ||
+      magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION ||
+      fingerprint != m_fingerprint) {
+    m_staleReason = "snapshot format or options changed";
+    return false;
+  }
+
+  uint32_t depCount = 0;
+  reader.get(depCount);
+  m_dependencies.clear();
+  for (uint32_t i = 0; i < depCount && reader.ok(); ++i) {
+    FileStamp stamp;
+    std::string_view path;
+    reader.get(stamp.kind);
+    reader.get(stamp.device);
+    reader.get(stamp.inode);
+    reader.get(stamp.mtimeNs);
+    reader.get(stamp.size);
+    reader.getString(path);
+    stamp.path = path;
+    m_dependencies.push_back(std::move(stamp));
+  }
+
+  uint32_t envCount = 0;
+  reader.get(envCount);
+  m_env.clear();
+  for (uint32_t i = 0; i < envCount && reader.ok(); ++i) {
+    EnvRecord record;
+    uint8_t present = 0;
+    reader.getString(record.name);
+    reader.get(present);
+    reader.getString(record.value);
+    record.present = present != 0;
+    m_env.push_back(record);
+  }
+
+  reader.getString(m_parseError);
+  reader.get(m_entryCount);
+  size_t offsetsStart = reader.offset();
+  if (!reader.ok() ||
+      m_file.size() - offsetsStart < size_t(m_entryCount) * sizeof(uint32_t)) {
+    m_staleReason = "snapshot is truncated";
+    return false;
+  }
+  m_offsets = m_file.view().substr(offsetsStart,
+                                   size_t(m_entryCount) * sizeof(uint32_t));
+  m_entries = m_file.view().substr(offsetsStart + m_offsets.size());
+  return true;
+}
+
+bool ConfigCache::isFresh() {
+  for (const auto &dep : m_dependencies) {
+    if (!FileStamp::capture(dep.path).matches(dep)) {
+      m_staleReason = "dependency changed: " + dep.path;
+      return false;
+    }
+  }
+  for (const auto &env : m_env) {
+    const char *current = getenv(std::string(env.name).c_str());
+    if ((current != nullptr) != env.present ||
+        (current && env.value != current)) {
+      m_staleReason = "environment changed: $" + std::string(env.name);
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string_view ConfigCache::entryKeyAt(uint32_t index) const {
+  uint32_t offset = 0;
+  std::memcpy(&offset, m_offsets.data() + size_t(index) * sizeof(offset),
+              sizeof(offset));
+  ByteReader reader(m_entries);
+  std::string_view key;
+  if (!reader.seek(offset) || !reader.getString(key))
+    return {};
+  return key;
+}
+
+std::optional<CachedValue>
+ConfigCache::lookup(std::string_view key) const {
+  uint32_t lo = 0, hi = m_entryCount;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (entryKeyAt(mid) < key)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo == m_entryCount || entryKeyAt(lo) != key)
+    return std::nullopt;
+
+  uint32_t offset = 0;
+  std::memcpy(&offset, m_offsets.data() + size_t(lo) * sizeof(offset),
+              sizeof(offset));
+  ByteReader reader(m_entries);
+  std::string_view storedKey;
+  CachedValue value;
+  reader.seek(offset);
+  reader.getString(storedKey);
+  reader.getString(value.type);
+  if (!getValue(reader, value.value))
+    return std::nullopt;
+  return value;
+}
+
+bool ConfigCache::store(const SnapshotData &data) const {
+  std::vector<const CacheEntry *> entries;
+  entries.reserve(data.entries.size());
+  for (const auto &entry : data.entries)
+    entries.push_back(&entry);
+  std::sort(entries.begin(), entries.end(),
+            [](const CacheEntry *a, const CacheEntry *b) {
+              return a->key < b->key;
+            });
+  entries.erase(std::unique(entries.begin(), entries.end(),
+                            [](const CacheEntry *a, const CacheEntry *b) {
+                              return a->key == b->key;
+                            }),
+                entries.end());
+
+  ByteWriter writer;
+  writer.put(SNAPSHOT_MAGIC);
+  writer.put(SNAPSHOT_VERSION);
+  writer.put(m_fingerprint);
+
+  writer.put<uint32_t>(data.dependencies.size());
+  for (const auto &dep : data.dependencies) {
+    writer.put(dep.kind);
+    writer.put(dep.device);
+    writer.put(dep.inode);
+    writer.put(dep.mtimeNs);
+    writer.put(dep.size);
+    writer.putString(dep.path);
+  }
+
+  writer.put<uint32_t>(data.envNames.size());
+  for (const auto &name : data.envNames) {
+    const char *value = getenv(name.c_str());
+    writer.putString(name);
+    writer.put<uint8_t>(value != nullptr);
+    writer.putString(value ? value : "");
+  }
+
+  writer.putString(data.parseError);
+  writer.put<uint32_t>(entries.size());
+
+  size_t offsetTable = writer.size();
+  for (size_t i = 0; i < entries.size(); ++i)
+    writer.put<uint32_t>(0);
+  size_t entriesStart = writer.size();
+  for (size_t i = 0; i < entries.size(); ++i) {
+    writer.patch<uint32_t>(offsetTable + i * sizeof(uint32_t),
+                           writer.size() - entriesStart);
+    writer.putString(entries[i]->key);
+    writer.putString(entries[i]->type);
+    putValue(writer, entries[i]->value);
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(m_snapshotPath).parent_path(), ec);
+
+  // Jobs on other threads of this process may store the same snapshot, so
+  // every writer gets a file of its own
+  std::string tmpPath = m_snapshotPath + ".XXXXXX";
+  int fd = mkstemp(tmpPath.data());
+  FILE *file = fd >= 0 ? fdopen(fd, "wb") : nullptr;
+  if (!file) {
+    if (fd >= 0) {
+      close(fd);
+      unlink(tmpPath.c_str());
+    }
+    spdlog::debug("[cache] Cannot write snapshot {}", tmpPath);
+    return false;
+  }
+  bool written = fwrite(writer.buffer().data(), 1, writer.size(), file) ==
+                 writer.size();
+  written = (fclose(file) == 0) && written;
+  if (!written || rename(tmpPath.c_str(), m_snapshotPath.c_str()) != 0) {
+    unlink(tmpPath.c_str());
+    spdlog::debug("[cache] Failed to store snapshot {}", m_snapshotPath);
+    return false;
+  }
+  return true;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include "Value.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <vector>
+
+namespace hyprquery {
+
+// Identity of a file or directory at a point in time. A snapshot is only
+// reused while every recorded stamp still matches the filesystem.
+struct FileStamp {
+  enum class Kind : uint8_t { Missing, File, Directory };
+
+  std::string path;
+  Kind kind = Kind::Missing;
+  uint64_t device = 0;
+  uint64_t inode = 0;
+  int64_t mtimeNs = 0;
+  uint64_t size = 0;
+
+  static FileStamp capture(const std::string &path);
+  // Stamp from a stat() already made, st is null for a missing path
+  static FileStamp fromStat(const std::string &path, const struct stat *st);
+  bool matches(const FileStamp &other) const;
+};
+
+struct CachedValue {
+  std::string_view type;
+  Value value;
+};
+
+struct CacheEntry {
+  std::string key;
+  std::string type;
+  Value value;
+};
+
+// Everything a cold run needs to hand over to produce a snapshot
+struct SnapshotData {
+  std::vector<FileStamp> dependencies;
+  std::vector<std::string> envNames;
+  std::string parseError;
+  std::vector<CacheEntry> entries;
+};
+
+// On-disk snapshot of the resolved key/value table of one config, keyed by
+// the full source graph it was parsed from
+class ConfigCache {
+public:
+  ConfigCache(std::string snapshotPath, uint64_t fingerprint);
+
+  // Snapshot location for a config/schema/options combination
+  static std::string defaultSnapshotPath(const std::string &configPath,
+                                         const std::string &schemaPath,
+                                         uint64_t fingerprint);
+
+  // Collect the names of `$NAME` references in config text; hyprlang falls
+  // back to the environment for any name that is not a config variable
+  static void collectEnvReferences(std::string_view text,
+                                   std::vector<std::string> &names);
+
+  // Map the snapshot; false if it is missing, corrupt or from another build
+  bool open();
+
+  // Re-stat every dependency and re-read every referenced env variable
+  bool isFresh();
+
+  std::optional<CachedValue> lookup(std::string_view key) const;
+  std::string_view parseError() const { return m_parseError; }
+  const std::string &staleReason() const { return m_staleReason; }
+  const std::string &path() const { return m_snapshotPath; }
+
+  // Atomically replace the snapshot on disk
+  bool store(const SnapshotData &data) const;
+
+private:
+  struct EnvRecord {
+    std::string_view name;
+    bool present;
+    std::string_view value;
+  };
+
+  std::string_view entryKeyAt(uint32_t index) const;
+
+  std::string m_snapshotPath;
+  uint64_t m_fingerprint;
+  MappedFile m_file;
+  std::vector<FileStamp> m_dependencies;
+  std::vector<EnvRecord> m_env;
+  std::string_view m_parseError;
+  std::string_view m_entries;
+  std::string_view m_offsets;
+  uint32_t m_entryCount = 0;
+  std::string m_staleReason;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,245 @@
+#include "ConfigScanner.hpp"
+#include "InputFiles.hpp"
+#include "PathCache.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <glob.h>
+#include <spdlog/spdlog.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace hyprquery {
+
+namespace {
+
+std::string_view trim(std::string_view str) {
+  size_t start = str.find_first_not_of(" \t\r");
+  if (start == std::string_view::npos)
+    return {};
+  size_t end = str.find_last_not_of(" \t\r");
+  return str.substr(start, end - start + 1);
+}
+
+// Substitute $NAME from the variables seen so far, then the environment
+std::string expandVariables(
+    std::string_view value,
+    const std::unordered_map<std::string, std::string> &variables) {
+  std::string out;
+  for (size_t i = 0; i < value.size(); ++i) {
+    if (value[i] != '$') {
+      out.push_back(value[i]);
+      continue;
+    }
+    size_t end = i + 1;
+    while (end < value.size() &&
+           (std::isalnum(static_cast<unsigned char>(value[end])) ||
+            value[end] == '_'))
+      ++end;
+    std::string name(value.substr(i + 1, end - i - 1));
+    if (auto it = variables.find(name); it != variables.end()) {
+      out += it->second;
+    } else if (const char *env = getenv(name.c_str())) {
+      out += env;
+    } else {
+      out += value.substr(i, end - i);
+    }
+    i = end - 1;
+  }
+  return out;
+}
+
+class KeyCollector {
+public:
+  explicit KeyCollector(
+      bool followSource,
+      std::unordered_map<std::string, KeyLocation> *locations = nullptr)
+      : m_followSource(followSource), m_locations(locations) {}
+
+  void collect(const std::string &path) {
+    if (!m_visited.insert(path).second)
+      return;
+    auto file = InputFiles::map(path);
+    if (!file->isOpen())
+      return;
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    ConfigScanner::scan(file->view(), [&](const ScannedLine &line) {
+      if (line.isVariable) {
+        m_variables[std::string(line.key.substr(1))] =
+            expandVariables(line.value, m_variables);
+      } else if (line.key == "source") {
+        if (m_followSource)
+          collectSource(dir, expandVariables(line.value, m_variables));
+      } else {
+        m_keys.emplace_back(line.key);
+        if (m_locations) {
+          if (auto it = m_locations->find(m_keys.back());
+              it != m_locations->end())
+            it->second = {path, line.lineNumber};
+        }
+      }
+    });
+  }
+
+  std::vector<std::string> keys() {
+    std::sort(m_keys.begin(), m_keys.end());
+    m_keys.erase(std::unique(m_keys.begin(), m_keys.end()), m_keys.end());
+    return std::move(m_keys);
+  }
+
+  std::vector<std::string> variables() const {
+    std::vector<std::string> names;
+    names.reserve(m_variables.size());
+    for (const auto &[name, value] : m_variables)
+      names.push_back("$" + name);
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+private:
+  void collectSource(const std::string &dir, const std::string &path) {
+    for (const auto &match : ConfigScanner::expandSource(dir, path)) {
+      if (PathCache::status(match).isFile())
+        collect(match);
+    }
+  }
+
+  bool m_followSource;
+  std::unordered_map<std::string, KeyLocation> *m_locations;
+  std::unordered_set<std::string> m_visited;
+  std::unordered_map<std::string, std::string> m_variables;
+  std::vector<std::string> m_keys;
+};
+
+} // namespace
+
+bool ConfigScanner::scan(std::string_view text, const Callback &callback) {
+  bool understood = true;
+  std::string categories;
+  std::vector<size_t> categoryStarts;
+  std::string key;
+  std::string value;
+  size_t lineNumber = 0;
+  while (!text.empty()) {
+    ++lineNumber;
+    size_t newline = text.find('\n');
+    std::string_view raw = text.substr(0, newline);
+    text.remove_prefix(newline == std::string_view::npos ? text.size()
+                                                         : newline + 1);
+
+    // `#` starts a comment, `##` is a literal `#`
+    value.clear();
+    for (size_t i = 0; i < raw.size(); ++i) {
+      if (raw[i] == '#') {
+        if (i + 1 < raw.size() && raw[i + 1] == '#') {
+          value.push_back('#');
+          ++i;
+          continue;
+        }
+        break;
+      }
+      value.push_back(raw[i]);
+    }
+    std::string_view line = trim(value);
+    if (line.empty())
+      continue;
+
+    if (line == "}") {
+      if (categoryStarts.empty()) {
+        understood = false;
+        continue;
+      }
+      categories.resize(categoryStarts.back());
+      categoryStarts.pop_back();
+      continue;
+    }
+    if (line.back() == '{') {
+      categoryStarts.push_back(categories.size());
+      categories += trim(line.substr(0, line.size() - 1));
+      categories += ':';
+      continue;
+    }
+
+    size_t eq = line.find('=');
+    if (eq == std::string_view::npos) {
+      understood = false;
+      continue;
+    }
+    std::string_view lhs = trim(line.substr(0, eq));
+    std::string_view rhs = trim(line.substr(eq + 1));
+    if (lhs.empty()) {
+      understood = false;
+      continue;
+    }
+    if (lhs.front() == '$') {
+      callback({lhs, rhs, true, lineNumber});
+      continue;
+    }
+    key = categories;
+    key += lhs;
+    callback({key, rhs, false, lineNumber});
+  }
+  return understood && categoryStarts.empty();
+}
+
+std::vector<std::string> ConfigScanner::expandSource(const std::string &dir,
+                                                     std::string path) {
+  std::vector<std::string> paths;
+  if (path.empty())
+    return paths;
+  if (path[0] == '~') {
+    const char *home = getenv("HOME");
+    if (home)
+      path = std::string(home) + path.substr(1);
+  } else if (path[0] != '/') {
+    path = dir + "/" + path;
+  }
+  PathCache::glob(path, GLOB_TILDE, paths);
+  return paths;
+}
+
+std::vector<std::string> ConfigScanner::sourcedFiles(std::string_view text,
+                                                     const std::string &dir) {
+  std::vector<std::string> paths;
+  std::unordered_map<std::string, std::string> variables;
+  scan(text, [&](const ScannedLine &line) {
+    if (line.isVariable) {
+      variables[std::string(line.key.substr(1))] =
+          expandVariables(line.value, variables);
+    } else if (line.key == "source") {
+      auto matches = expandSource(dir, expandVariables(line.value, variables));
+      paths.insert(paths.end(), matches.begin(), matches.end());
+    }
+  });
+  return paths;
+}
+
+std::vector<std::string>
+ConfigScanner::collectKeys(const std::string &configPath, bool followSource,
+                           std::vector<std::string> *variables) {
+  PathCache::Scope paths;
+  KeyCollector collector(followSource);
+  collector.collect(configPath);
+  if (variables)
+    *variables = collector.variables();
+  auto keys = collector.keys();
+  spdlog::debug("[scan] Found {} assigned keys", keys.size());
+  return keys;
+}
+
+std::unordered_map<std::string, KeyLocation>
+ConfigScanner::locateKeys(const std::string &configPath, bool followSource,
+                          const std::vector<std::string> &keys) {
+  std::unordered_map<std::string, KeyLocation> locations;
+  for (const auto &key : keys)
+    locations.try_emplace(key);
+  PathCache::Scope paths;
+  KeyCollector collector(followSource, &locations);
+  collector.collect(configPath);
+  std::erase_if(locations,
+                [](const auto &entry) { return entry.second.line == 0; });
+  return locations;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace hyprquery {
+
+// One `key = value` line, with the enclosing categories already prefixed
+struct ScannedLine {
+  std::string_view key;
+  std::string_view value;
+  bool isVariable = false;
+  // 1-based
+  size_t lineNumber = 0;
+};
+
+struct KeyLocation {
+  std::string file;
+  size_t line = 0;
+};
+
+// Lightweight line scanner for hyprlang syntax. It only splits lines into
+// assignments; values are not expanded or validated.
+class ConfigScanner {
+public:
+  using Callback = std::function<void(const ScannedLine &line)>;
+
+  // Scan one file's text; false if a line could not be understood
+  static bool scan(std::string_view text, const Callback &callback);
+
+  // Every key assigned in the config and, when followSource is set, in the
+  // files it sources; sorted and unique. The variables they define go to
+  // variables as $NAME, in the same order.
+  static std::vector<std::string>
+  collectKeys(const std::string &configPath, bool followSource,
+              std::vector<std::string> *variables = nullptr);
+
+  // Where each of keys is assigned last, following source= lines in the
+  // order hyprlang parses them when followSource is set. Keys that are
+  // never assigned are left out.
+  static std::unordered_map<std::string, KeyLocation>
+  locateKeys(const std::string &configPath, bool followSource,
+             const std::vector<std::string> &keys);
+
+  // Glob a source= value relative to dir, like SourceHandler::handleSource
+  static std::vector<std::string> expandSource(const std::string &dir,
+                                               std::string path);
+
+  // Files the source= lines of one file's text refer to; variables are
+  // taken from the same text and the environment
+  static std::vector<std::string> sourcedFiles(std::string_view text,
+                                               const std::string &dir);
+};
+
+} // namespace hyprquery
@@ -1,10 +1,15 @@
 #include "ConfigUtils.hpp"
+#include "KeyIndex.hpp"
+#include "PathCache.hpp"
+#include "QueryFilter.hpp"
+#include "Schema.hpp"
+#include <cctype>
+#include <charconv>
+#include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <nlohmann/json.hpp>
 #include <regex>
+#include <stdexcept>
 #include <spdlog/spdlog.h>
-#include <wordexp.h>
 
 namespace hyprquery {
 
@@ -14,7 +19,20 @@ parseQueryInputs(const std::vector<std::string> &rawQueries) {
   for (size_t i = 0; i < rawQueries.size(); ++i) {
     QueryInput qi;
     qi.index = i;
-    const std::string &raw = rawQueries[i];
+    std::string raw = rawQueries[i];
+    // A color format follows the filters, whose regex may contain '|'
+    size_t lastBracket = raw.rfind(']');
+    size_t pipe = raw.find(
+        '|', lastBracket == std::string::npos ? 0 : lastBracket + 1);
+    if (pipe != std::string::npos) {
+      std::string name = raw.substr(pipe + 1);
+      auto format = colorFormatFromString(name);
+      if (!format)
+        throw std::invalid_argument("Unknown color format '" + name +
+                                    "' in query '" + rawQueries[i] + "'");
+      qi.colorFormat = *format;
+      raw.resize(pipe);
+    }
     size_t firstBracket = raw.find('[');
     if (firstBracket == std::string::npos) {
       qi.query = raw;
@@ -48,88 +66,83 @@ parseQueryInputs(const std::vector<std::string> &rawQueries) {
         raw.substr(thirdBracket + 1, fourthBracket - thirdBracket - 1);
     queries.push_back(qi);
   }
+  for (auto &qi : queries) {
+    qi.isPattern = isKeyPattern(qi.query);
+    try {
+      qi.filter = QueryFilter::get(qi.expectedType, qi.expectedRegex);
+    } catch (const std::invalid_argument &e) {
+      throw std::invalid_argument(std::string(e.what()) + " in query '" +
+                                  rawQueries[qi.index] + "'");
+    }
+  }
   return queries;
 }
 
-void ConfigUtils::addConfigValuesFromSchema(Hyprlang::CConfig &config,
-                                            const std::string &schemaFilePath) {
-  std::ifstream schemaFile(schemaFilePath);
-  if (!schemaFile.is_open()) {
-    spdlog::error("Failed to open schema file: {}", schemaFilePath);
-    return;
-  }
-
-  nlohmann::json schemaJson;
-  try {
-    schemaFile >> schemaJson;
-  } catch (const std::exception &e) {
-    spdlog::error("Failed to parse schema JSON: {}", e.what());
-    return;
+std::vector<std::string>
+ConfigUtils::addConfigValuesFromSchema(Hyprlang::CConfig &config,
+                                       const Schema &schema) {
+  std::vector<std::string> registered;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &option : schema.options()) {
+    if (Schema::registerOption(config, option))
+      registered.emplace_back(option.key);
   }
+  spdlog::debug("[schema] Registered {} of {} options in {}us",
+                registered.size(), schema.options().size(),
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+  return registered;
+}
 
-  if (!schemaJson.contains("hyprlang_schema")) {
-    spdlog::error("Invalid schema format: missing 'hyprlang_schema' key");
-    return;
+std::vector<std::string>
+ConfigUtils::addConfigValuesFromSchema(Hyprlang::CConfig &config,
+                                       const Schema &schema,
+                                       const std::vector<std::string> &keys) {
+  std::vector<std::string> registered;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &key : keys) {
+    auto option = schema.find(key);
+    if (option && Schema::registerOption(config, *option))
+      registered.push_back(key);
   }
+  spdlog::debug("[schema] Registered {} of {} requested options lazily in {}us",
+                registered.size(), keys.size(),
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+  return registered;
+}
 
-  for (const auto &option : schemaJson["hyprlang_schema"]) {
-    if (!option.contains("value") || !option.contains("type") ||
-        !option.contains("data")) {
-      spdlog::error("Invalid schema option format");
-      continue;
-    }
-
-    std::string value = option["value"].get<std::string>();
-    std::string type = option["type"].get<std::string>();
-
-    if (type == "INT" && option["data"].contains("default")) {
-      config.addConfigValue(
-          value.c_str(), (Hyprlang::INT)option["data"]["default"].get<int>());
-    } else if (type == "FLOAT" && option["data"].contains("default")) {
-      config.addConfigValue(
-          value.c_str(),
-          (Hyprlang::FLOAT)option["data"]["default"].get<float>());
-    } else if ((type == "STRING_SHORT" || type == "STRING_LONG") &&
-               option["data"].contains("default")) {
-      config.addConfigValue(value.c_str(),
-                            (Hyprlang::STRING)option["data"]["default"]
-                                .get<std::string>()
-                                .c_str());
-    } else if (type == "BOOL" && option["data"].contains("default")) {
-      config.addConfigValue(
-          value.c_str(), (Hyprlang::INT)option["data"]["default"].get<bool>());
-    } else if ((type == "GRADIENT" || type == "COLOR") &&
-               option["data"].contains("default")) {
-      config.addConfigValue(value.c_str(),
-                            (Hyprlang::STRING)option["data"]["default"]
-                                .get<std::string>()
-                                .c_str());
-    } else if (type == "VECTOR" && option["data"].contains("default")) {
-      if (option["data"]["default"].is_array() &&
-          option["data"]["default"].size() == 2) {
-        Hyprlang::VEC2 vec;
-        vec.x = option["data"]["default"][0].get<float>();
-        vec.y = option["data"]["default"][1].get<float>();
-        config.addConfigValue(value.c_str(), vec);
-      }
-    }
-  }
+namespace {
+
+// hyprlang keeps FLOAT and VEC2 in single precision. The shortest text of
+// the float read back as a double is the closest double to what the config
+// says.
+double widen(float value) {
+  char buffer[32];
+  char *end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+  double wide = value;
+  std::from_chars(buffer, end, wide);
+  return wide;
 }
 
-std::string ConfigUtils::convertValueToString(const std::any &value) {
+} // namespace
+
+Value ConfigUtils::convertValue(const std::any &value) {
   if (value.type() == typeid(Hyprlang::INT)) {
-    return std::to_string(std::any_cast<Hyprlang::INT>(value));
+    return std::any_cast<Hyprlang::INT>(value);
   } else if (value.type() == typeid(Hyprlang::FLOAT)) {
-    return std::to_string(std::any_cast<Hyprlang::FLOAT>(value));
+    return widen(std::any_cast<Hyprlang::FLOAT>(value));
   } else if (value.type() == typeid(Hyprlang::STRING)) {
-    return std::any_cast<Hyprlang::STRING>(value);
+    return std::string(std::any_cast<Hyprlang::STRING>(value));
   } else if (value.type() == typeid(Hyprlang::VEC2)) {
     const auto &vec = std::any_cast<Hyprlang::VEC2>(value);
-    return std::to_string(vec.x) + ", " + std::to_string(vec.y);
+    return Vec2{widen(vec.x), widen(vec.y)};
   } else if (value.has_value()) {
-    return "non-standard value";
+    return std::string("non-standard value");
   } else {
-    return "UNSET";
+    return {};
   }
 }
 
@@ -191,56 +204,72 @@ ConfigUtils::cleanCmdForWorkspace(const std::string &name,
   return result;
 }
 
-std::string ConfigUtils::normalizePath(const std::string &path) {
-
-  std::string processedPath = path;
-  if ((processedPath.front() == '"' && processedPath.back() == '"') ||
-      (processedPath.front() == '\'' && processedPath.back() == '\'')) {
-    processedPath = processedPath.substr(1, processedPath.length() - 2);
-  }
-
-  std::string expandedPath = processedPath;
-
-  if (expandedPath.find('$') != std::string::npos) {
-    wordexp_t p;
-
-    if (wordexp(expandedPath.c_str(), &p, WRDE_NOCMD) == 0) {
-      if (p.we_wordc > 0 && p.we_wordv[0] != nullptr) {
-        expandedPath = p.we_wordv[0];
-      }
-      wordfree(&p);
+std::string ConfigUtils::expandPath(std::string_view path) {
+  std::string out;
+  out.reserve(path.size());
+  size_t i = 0;
+  if (path.starts_with('~') && (path.size() == 1 || path[1] == '/')) {
+    if (const char *home = getenv("HOME")) {
+      out = home;
+      i = 1;
     }
   }
-
-  if (expandedPath.starts_with("~") &&
-      (expandedPath.size() == 1 || expandedPath[1] == '/')) {
-    const char *home = getenv("HOME");
-    if (home) {
-      expandedPath.replace(0, 1, home);
+  while (i < path.size()) {
+    size_t dollar = path.find('$', i);
+    out.append(path.substr(i, dollar - i));
+    if (dollar == std::string_view::npos)
+      break;
+    i = dollar + 1;
+    bool braced = i < path.size() && path[i] == '{';
+    size_t start = i + braced;
+    size_t end = start;
+    auto charAt = [&](size_t at) {
+      return static_cast<unsigned char>(path[at]);
+    };
+    // A leading digit is a positional parameter of its own, like $1
+    if (end < path.size() && std::isdigit(charAt(end))) {
+      ++end;
+    } else {
+      while (end < path.size() &&
+             (std::isalnum(charAt(end)) || path[end] == '_'))
+        ++end;
+    }
+    // Not a variable reference, the `$` stays
+    if (end == start || (braced && (end == path.size() || path[end] != '}'))) {
+      out.push_back('$');
+      continue;
     }
+    std::string name(path.substr(start, end - start));
+    if (const char *value = getenv(name.c_str()))
+      out += value;
+    i = end + braced;
   }
+  return out;
+}
 
-  std::filesystem::path fsPath(expandedPath);
-
-  if (fsPath.is_relative()) {
+std::string ConfigUtils::normalizePath(const std::string &path) {
+  std::string_view unquoted = path;
+  if (unquoted.size() >= 2 &&
+      ((unquoted.front() == '"' && unquoted.back() == '"') ||
+       (unquoted.front() == '\'' && unquoted.back() == '\'')))
+    unquoted = unquoted.substr(1, unquoted.size() - 2);
+  if (unquoted.empty())
+    return {};
+
+  std::filesystem::path fsPath(expandPath(unquoted));
+  if (fsPath.is_relative())
     fsPath = std::filesystem::absolute(fsPath);
-  }
-
-  if (std::filesystem::exists(fsPath)) {
-    return std::filesystem::canonical(fsPath).string();
-  }
-
-  if (std::filesystem::exists(fsPath.parent_path())) {
-    return std::filesystem::weakly_canonical(fsPath).string();
-  }
 
+  // The file itself, or else its directory, resolved through the cache
+  std::string canonical = PathCache::canonical(fsPath.string());
+  if (!canonical.empty())
+    return canonical;
+  std::string parent = PathCache::canonical(fsPath.parent_path().string());
+  if (!parent.empty())
+    return (std::filesystem::path(parent) / fsPath.filename())
+        .lexically_normal()
+        .string();
   return fsPath.lexically_normal().string();
 }
 
-std::string normalizeType(const std::string &type) {
-  std::string out = type;
-  std::transform(out.begin(), out.end(), out.begin(), ::toupper);
-  return out;
-}
-
 } // namespace hyprquery
\ No newline at end of file
@@ -1,39 +1,60 @@
 #pragma once
 
+#include "Value.hpp"
 #include <any>
 #include <hyprlang.hpp>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace hyprquery {
 
+class Schema;
+class QueryFilter;
+
 struct QueryInput {
   std::string query;
   std::string expectedType;
   std::string expectedRegex;
   size_t index;
   bool isDynamicVariable = false;
+  // Glob or category prefix, expanded into one result per matching key
+  bool isPattern = false;
+  // expectedType and expectedRegex compiled, null when both are empty
+  std::shared_ptr<const QueryFilter> filter;
+  // From a trailing |hex, |hexa, |rgba, |int or |json
+  ColorFormat colorFormat = ColorFormat::None;
 };
 
 struct QueryResult {
   std::string key;
-  std::string value;
+  Value value;
   std::string type;
   std::vector<std::string> flags;
+  // Config file the result came from when several were queried at once
+  std::string file;
 };
 
-std::string normalizeType(const std::string &type);
-
+// Throws std::invalid_argument for a query with an invalid regex or an
+// unknown color format
 std::vector<QueryInput>
 parseQueryInputs(const std::vector<std::string> &rawQueries);
 
 class ConfigUtils {
 public:
-  static void addConfigValuesFromSchema(Hyprlang::CConfig &config,
-                                        const std::string &schemaFilePath);
+  // Register every schema option with its default; returns the keys added
+  static std::vector<std::string>
+  addConfigValuesFromSchema(Hyprlang::CConfig &config, const Schema &schema);
+  // Register only the listed keys the schema knows, through its index
+  static std::vector<std::string>
+  addConfigValuesFromSchema(Hyprlang::CConfig &config, const Schema &schema,
+                            const std::vector<std::string> &keys);
 
-  static std::string convertValueToString(const std::any &value);
+  // The hyprlang value in its native type; floats are widened so that
+  // they print as written, 0.1 and not 0.10000000149011612
+  static Value convertValue(const std::any &value);
   static std::string getValueTypeName(const std::any &value);
 
   static std::optional<int64_t> configStringToInt(const std::string &str);
@@ -44,6 +65,11 @@ public:
   static std::optional<std::string>
   cleanCmdForWorkspace(const std::string &name, const std::string &cmd);
 
+  // $VAR, ${VAR} and a leading ~ taken from the environment, like a shell
+  // word without command substitution
+  static std::string expandPath(std::string_view path);
+
+  // Unquoted, expanded and canonical as far as the path exists
   static std::string normalizePath(const std::string &path);
 };
 
@@ -0,0 +1,564 @@
+#include "Daemon.hpp"
+#include "BinaryIO.hpp"
+#include "InputFiles.hpp"
+#include "Io.hpp"
+#include "Output.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <poll.h>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr uint32_t PROTOCOL_VERSION = 2;
+constexpr uint32_t MAX_FRAME = 64 * 1024 * 1024;
+constexpr auto DEBOUNCE = std::chrono::milliseconds(100);
+constexpr auto CLIENT_TIMEOUT = std::chrono::seconds(2);
+// Further connections wait in the listen backlog
+constexpr size_t MAX_CLIENTS = 64;
+
+bool readAll(int fd, char *data, size_t len) {
+  while (len > 0) {
+    ssize_t n = recv(fd, data, len, 0);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data += n;
+    len -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+std::string frame(const std::string &payload) {
+  uint32_t len = static_cast<uint32_t>(payload.size());
+  std::string out(reinterpret_cast<const char *>(&len), sizeof(len));
+  out += payload;
+  return out;
+}
+
+bool writeFrame(int fd, const std::string &payload) {
+  return writeAll(fd, frame(payload));
+}
+
+// One decoded request frame. A request whose queries do not parse carries
+// its reply already.
+struct Request {
+  std::vector<QueryInput> queries;
+  std::string exportFormat;
+  std::string delimiter;
+  bool strict = false;
+  bool compact = false;
+  std::optional<std::string> reply;
+};
+
+// Nothing for a malformed request
+std::optional<Request> decodeRequest(std::string_view payload) {
+  ByteReader reader(payload);
+  uint32_t version = 0, count = 0;
+  uint8_t strict = 0, compact = 0;
+  std::string_view exportFormat, delimiter;
+  std::vector<std::string> rawQueries;
+  reader.get(version);
+  reader.getString(exportFormat);
+  reader.getString(delimiter);
+  reader.get(strict);
+  reader.get(compact);
+  reader.get(count);
+  for (uint32_t i = 0; i < count && reader.ok(); ++i) {
+    std::string_view raw;
+    reader.getString(raw);
+    rawQueries.emplace_back(raw);
+  }
+  if (!reader.ok() || version != PROTOCOL_VERSION) {
+    spdlog::debug("[daemon] Dropping malformed request");
+    return std::nullopt;
+  }
+
+  Request request;
+  request.exportFormat = exportFormat;
+  request.delimiter = delimiter;
+  request.strict = strict;
+  request.compact = compact;
+  // hyq checks queries before sending them, so only other clients get here
+  try {
+    request.queries = parseQueryInputs(rawQueries);
+  } catch (const std::invalid_argument &e) {
+    spdlog::debug("[daemon] {}", e.what());
+    ByteWriter writer;
+    writer.put(int32_t{106});
+    writer.putString("");
+    request.reply = writer.buffer();
+  }
+  return request;
+}
+
+// The response frame payload for a request engine can answer
+std::string answer(const QueryEngine &engine, const Request &request) {
+  int32_t exitCode = 0;
+  std::string output;
+  OutputWriter out(output);
+  if (!engine.parseError().empty() && request.strict) {
+    exitCode = 1;
+  } else {
+    std::vector<QueryResult> results = engine.executeQueries(request.queries);
+    for (const auto &r : results) {
+      if (r.type == "NULL")
+        exitCode = 1;
+    }
+    outputResults(out, results, request.exportFormat, request.delimiter,
+                  request.compact);
+  }
+
+  ByteWriter writer;
+  writer.put(exitCode);
+  writer.putString(output);
+  return writer.buffer();
+}
+
+// One client of the daemon. Its request is read and its response written
+// as far as the socket allows on every wakeup, so a client that stalls
+// only holds up itself.
+struct Connection {
+  int fd = -1;
+  std::string input;
+  std::optional<Request> request;
+  // Registered keys the engine has to include, 0 before registering
+  size_t keyCount = 0;
+  std::string output;
+  size_t written = 0;
+  bool responded = false;
+  // Dropped after CLIENT_TIMEOUT without progress, unless it waits for a
+  // rebuild
+  std::chrono::steady_clock::time_point deadline;
+
+  bool waiting() const { return request && !responded; }
+};
+
+// Read whatever the socket has; false once the peer closed or failed
+bool readAvailable(Connection &client) {
+  char chunk[4096];
+  while (client.input.size() <= sizeof(uint32_t) + MAX_FRAME) {
+    ssize_t n = recv(client.fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+    if (n > 0) {
+      client.input.append(chunk, static_cast<size_t>(n));
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+  }
+  return false;
+}
+
+// Write as much of the response as the socket takes; false on an error
+bool writeAvailable(Connection &client) {
+  while (client.written < client.output.size()) {
+    ssize_t n = send(client.fd, client.output.data() + client.written,
+                     client.output.size() - client.written,
+                     MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n > 0) {
+      client.written += static_cast<size_t>(n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+  }
+  return true;
+}
+
+bool readFrame(int fd, std::string &payload) {
+  uint32_t len = 0;
+  if (!readAll(fd, reinterpret_cast<char *>(&len), sizeof(len)) ||
+      len > MAX_FRAME)
+    return false;
+  payload.resize(len);
+  return readAll(fd, payload.data(), len);
+}
+
+bool fillAddress(const std::string &path, sockaddr_un &addr) {
+  if (path.size() >= sizeof(addr.sun_path))
+    return false;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+// The socket directory has to be a real directory only we can write to;
+// in a shared /tmp another user could have made it first and would then
+// be able to replace the socket and forge answers
+bool isPrivateDirectory(const std::string &dir) {
+  struct stat st;
+  return lstat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode) &&
+         st.st_uid == getuid() && (st.st_mode & 07777) == 0700;
+}
+
+int connectTo(const std::string &path) {
+  sockaddr_un addr;
+  if (!fillAddress(path, addr))
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+  if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+} // namespace
+
+Daemon::Daemon(EngineOptions options, std::string socketPath)
+    : m_options(std::move(options)), m_socketPath(std::move(socketPath)) {
+  m_options.trackDependencies = true;
+}
+
+Daemon::~Daemon() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+  }
+  m_reloadCv.notify_all();
+  if (m_reloader.joinable())
+    m_reloader.join();
+  if (m_reloadedFd >= 0)
+    close(m_reloadedFd);
+}
+
+std::string Daemon::defaultSocketPath(const EngineOptions &options) {
+  uint64_t hash = fnv1a(options.configPath);
+  hash = fnv1a(std::string_view("\0", 1), hash);
+  hash = fnv1a(options.schemaPath, hash);
+  hash = fnv1a(options.followSource ? "s1" : "s0", hash);
+  hash = fnv1a(options.getDefaults ? "d1" : "d0", hash);
+  hash = fnv1a(options.builtinSchema ? "b1" : "b0", hash);
+  hash = fnv1a(options.lazySchema ? "l1" : "l0", hash);
+  for (const auto &keyword : options.keywords)
+    hash = fnv1a("k" + keyword, hash);
+
+  std::string dir;
+  const char *runtime = getenv("XDG_RUNTIME_DIR");
+  if (runtime && *runtime)
+    dir = std::string(runtime) + "/hyprquery";
+  else
+    dir = "/tmp/hyprquery-" + std::to_string(getuid());
+  return fmt::format("{}/{:016x}.sock", dir, hash);
+}
+
+std::shared_ptr<QueryEngine>
+Daemon::buildEngine(const std::vector<std::string> &keys) {
+  InputFiles::Scope inputs;
+  auto engine = std::make_shared<QueryEngine>(m_options);
+  engine->prepareConfig({}, keys);
+  engine->parse();
+  if (!engine->parseError().empty())
+    spdlog::debug("[daemon] Parse error: {}", engine->parseError());
+  return engine;
+}
+
+std::shared_ptr<QueryEngine>
+Daemon::engineFor(const std::vector<QueryInput> &queries, size_t &keyCount) {
+  bool added = false;
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_engine && m_engine->covers(queries))
+      return m_engine;
+    if (keyCount == 0) {
+      for (const auto &q : queries) {
+        if (m_keySet.insert(q.query).second) {
+          m_keys.push_back(q.query);
+          added = true;
+        }
+      }
+      keyCount = m_keys.size();
+      m_reloadRequested = m_reloadRequested || added;
+    }
+    // An engine with all of their keys answers them even when covers()
+    // disagrees, as it does for patterns the config never matched
+    if (m_engine && m_engineKeys >= keyCount)
+      return m_engine;
+  }
+  if (added) {
+    spdlog::debug("[daemon] Registering new keys, rebuilding config");
+    m_reloadCv.notify_one();
+  }
+  return nullptr;
+}
+
+void Daemon::updateWatches() {
+  std::shared_ptr<QueryEngine> engine;
+  {
+    std::lock_guard lock(m_mutex);
+    engine = m_engine;
+  }
+  if (engine)
+    m_watcher.watch(engine->dependencies());
+}
+
+void Daemon::reloadLoop() {
+  while (true) {
+    std::vector<std::string> keys;
+    {
+      std::unique_lock lock(m_mutex);
+      m_reloadCv.wait(lock, [this] { return m_reloadRequested || m_stopping; });
+      if (m_stopping)
+        return;
+      m_reloadRequested = false;
+      keys = m_keys;
+    }
+    spdlog::debug("[daemon] Rebuilding config with {} keys", keys.size());
+    auto engine = buildEngine(keys);
+    {
+      std::lock_guard lock(m_mutex);
+      m_engine = engine;
+      m_engineKeys = keys.size();
+    }
+    uint64_t one = 1;
+    if (write(m_reloadedFd, &one, sizeof(one)) < 0)
+      spdlog::debug("[daemon] Failed to signal reload: {}", strerror(errno));
+  }
+}
+
+int Daemon::run() {
+  std::string dir = std::filesystem::path(m_socketPath).parent_path();
+  if (mkdir(dir.c_str(), 0700) == 0)
+    chmod(dir.c_str(), 0700);
+  if (!isPrivateDirectory(dir)) {
+    std::cerr << "Error: " << dir
+              << " is not a directory of mode 0700 owned by this user"
+              << std::endl;
+    return 1;
+  }
+
+  int existing = connectTo(m_socketPath);
+  if (existing >= 0) {
+    close(existing);
+    std::cerr << "Error: A daemon is already serving " << m_socketPath
+              << std::endl;
+    return 1;
+  }
+
+  sockaddr_un addr;
+  if (!fillAddress(m_socketPath, addr)) {
+    std::cerr << "Error: Socket path too long: " << m_socketPath << std::endl;
+    return 1;
+  }
+  int listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  unlink(m_socketPath.c_str());
+  if (listenFd < 0 ||
+      bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) !=
+          0 ||
+      listen(listenFd, 16) != 0) {
+    std::cerr << "Error: Cannot listen on " << m_socketPath << ": "
+              << strerror(errno) << std::endl;
+    if (listenFd >= 0)
+      close(listenFd);
+    return 1;
+  }
+  chmod(m_socketPath.c_str(), 0600);
+
+  m_engine = buildEngine({});
+  updateWatches();
+  m_reloadedFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  m_reloader = std::thread(&Daemon::reloadLoop, this);
+
+  catchStopSignals();
+
+  spdlog::debug("[daemon] Serving {} on {}", m_options.configPath,
+                m_socketPath);
+
+  using Clock = std::chrono::steady_clock;
+  std::vector<Connection> clients;
+  // Advance a client as far as its socket allows; false once it is done
+  auto advance = [&](Connection &client) {
+    if (!client.request) {
+      bool open = readAvailable(client);
+      uint32_t len = 0;
+      if (client.input.size() >= sizeof(len))
+        memcpy(&len, client.input.data(), sizeof(len));
+      if (len > MAX_FRAME)
+        return false;
+      if (client.input.size() < sizeof(len) ||
+          client.input.size() - sizeof(len) < len)
+        return open;
+      client.request = decodeRequest(
+          std::string_view(client.input).substr(sizeof(len), len));
+      if (!client.request)
+        return false;
+      if (client.request->reply) {
+        client.output = frame(*client.request->reply);
+        client.responded = true;
+      }
+    }
+    if (!client.responded) {
+      auto engine = engineFor(client.request->queries, client.keyCount);
+      // Served again once the rebuild is done
+      if (!engine)
+        return true;
+      client.output = frame(answer(*engine, *client.request));
+      client.responded = true;
+    }
+    return writeAvailable(client) && client.written < client.output.size();
+  };
+  auto serve = [&](Connection &client) {
+    size_t before = client.input.size() + client.written;
+    bool responded = client.responded;
+    bool open = advance(client);
+    if (client.input.size() + client.written != before ||
+        client.responded != responded)
+      client.deadline = Clock::now() + CLIENT_TIMEOUT;
+    return open;
+  };
+
+  bool changePending = false;
+  Clock::time_point changeDeadline;
+  std::vector<pollfd> fds;
+  while (!stopRequested()) {
+    fds.clear();
+    fds.push_back({listenFd,
+                   static_cast<short>(clients.size() < MAX_CLIENTS ? POLLIN
+                                                                   : 0),
+                   0});
+    fds.push_back({m_watcher.fd(), POLLIN, 0});
+    fds.push_back({m_reloadedFd, POLLIN, 0});
+    auto wake = changePending ? changeDeadline : Clock::time_point::max();
+    for (const auto &client : clients) {
+      short events = client.responded ? POLLOUT
+                     : client.request ? 0
+                                      : POLLIN;
+      fds.push_back({client.fd, events, 0});
+      if (!client.waiting())
+        wake = std::min(wake, client.deadline);
+    }
+    int timeout = -1;
+    if (wake != Clock::time_point::max()) {
+      auto left = std::chrono::ceil<std::chrono::milliseconds>(
+          wake - Clock::now());
+      timeout = static_cast<int>(
+          std::clamp<int64_t>(left.count(), 0, INT_MAX));
+    }
+    int ready = poll(fds.data(), fds.size(), timeout);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      spdlog::error("poll failed: {}", strerror(errno));
+      break;
+    }
+    auto now = Clock::now();
+    if (changePending && now >= changeDeadline) {
+      // Quiet for a whole debounce window; editors are done writing
+      changePending = false;
+      {
+        std::lock_guard lock(m_mutex);
+        m_reloadRequested = true;
+      }
+      m_reloadCv.notify_one();
+    }
+    if ((fds[1].revents & POLLIN) && m_watcher.readEvents()) {
+      changePending = true;
+      changeDeadline = now + DEBOUNCE;
+    }
+    bool reloaded = false;
+    if (fds[2].revents & POLLIN) {
+      uint64_t count = 0;
+      reloaded = read(m_reloadedFd, &count, sizeof(count)) > 0;
+      if (reloaded)
+        updateWatches();
+    }
+    for (size_t i = 0; i < clients.size(); ++i) {
+      Connection &client = clients[i];
+      bool open = true;
+      if (fds[3 + i].revents != 0 || (reloaded && client.waiting()))
+        open = serve(client);
+      if (open && !client.waiting() && Clock::now() >= client.deadline) {
+        spdlog::debug("[daemon] Dropping a client that stalled");
+        open = false;
+      }
+      if (!open) {
+        close(client.fd);
+        client.fd = -1;
+      }
+    }
+    std::erase_if(clients, [](const Connection &c) { return c.fd < 0; });
+    if (fds[0].revents & POLLIN) {
+      int clientFd =
+          accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (clientFd >= 0) {
+        Connection client;
+        client.fd = clientFd;
+        client.deadline = now + CLIENT_TIMEOUT;
+        // A request is usually waiting already
+        if (serve(client))
+          clients.push_back(std::move(client));
+        else
+          close(clientFd);
+      }
+    }
+  }
+
+  for (const auto &client : clients)
+    close(client.fd);
+  close(listenFd);
+  unlink(m_socketPath.c_str());
+  spdlog::debug("[daemon] Stopped");
+  return 0;
+}
+
+std::optional<int> Daemon::query(const std::string &socketPath,
+                                 const DaemonRequest &request) {
+  std::string dir = std::filesystem::path(socketPath).parent_path();
+  if (!isPrivateDirectory(dir)) {
+    std::error_code ec;
+    if (std::filesystem::exists(dir, ec))
+      spdlog::warn("Not connecting to {}: {} is not a directory of mode "
+                   "0700 owned by this user",
+                   socketPath, dir);
+    return std::nullopt;
+  }
+  int fd = connectTo(socketPath);
+  if (fd < 0)
+    return std::nullopt;
+
+  ByteWriter writer;
+  writer.put(PROTOCOL_VERSION);
+  writer.putString(request.exportFormat);
+  writer.putString(request.delimiter);
+  writer.put<uint8_t>(request.strictMode);
+  writer.put<uint8_t>(request.compact);
+  writer.put<uint32_t>(request.rawQueries.size());
+  for (const auto &raw : request.rawQueries)
+    writer.putString(raw);
+
+  std::string payload;
+  bool ok = writeFrame(fd, writer.buffer()) && readFrame(fd, payload);
+  close(fd);
+  if (!ok)
+    return std::nullopt;
+
+  ByteReader reader(payload);
+  int32_t exitCode = 0;
+  std::string_view output;
+  if (!reader.get(exitCode) || !reader.getString(output))
+    return std::nullopt;
+  std::cout << output << std::flush;
+  return exitCode;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "FileWatcher.hpp"
+#include "QueryEngine.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace hyprquery {
+
+// One query invocation as sent by `hyq --connect`
+struct DaemonRequest {
+  std::vector<std::string> rawQueries;
+  std::string exportFormat;
+  std::string delimiter = "\n";
+  bool strictMode = false;
+  bool compact = false;
+};
+
+// Keeps a parsed config resident and answers requests on a Unix socket.
+// The config is reparsed in the background whenever a file of its source
+// graph changes, and when a request asks for a key that was never
+// registered. That request is answered once the rebuild is done; the
+// others keep being served from the current engine meanwhile.
+class Daemon {
+public:
+  Daemon(EngineOptions options, std::string socketPath);
+  ~Daemon();
+
+  // Serve until SIGINT or SIGTERM; returns the process exit code
+  int run();
+
+  // Socket location for a config/schema/options combination
+  static std::string defaultSocketPath(const EngineOptions &options);
+
+  // Forward a request to a running daemon and print its answer; nothing if
+  // no daemon is listening on socketPath
+  static std::optional<int> query(const std::string &socketPath,
+                                  const DaemonRequest &request);
+
+private:
+  std::shared_ptr<QueryEngine>
+  buildEngine(const std::vector<std::string> &keys);
+  // The current engine if it can answer queries. Otherwise their keys are
+  // registered for a background rebuild, keyCount becomes the number of
+  // keys that rebuild has to include, and the result is null until an
+  // engine with them is ready.
+  std::shared_ptr<QueryEngine>
+  engineFor(const std::vector<QueryInput> &queries, size_t &keyCount);
+  void updateWatches();
+  void reloadLoop();
+
+  EngineOptions m_options;
+  std::string m_socketPath;
+  FileWatcher m_watcher;
+
+  // Guards m_engine, m_keys and the reload state
+  std::mutex m_mutex;
+  std::shared_ptr<QueryEngine> m_engine;
+  // How many of m_keys m_engine registered
+  size_t m_engineKeys = 0;
+  std::vector<std::string> m_keys;
+  std::unordered_set<std::string> m_keySet;
+
+  std::thread m_reloader;
+  std::condition_variable m_reloadCv;
+  bool m_reloadRequested = false;
+  bool m_stopping = false;
+  int m_reloadedFd = -1;
+};
+
+} // namespace hyprquery
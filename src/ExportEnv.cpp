@@ -1,16 +1,28 @@
-#include "ConfigUtils.hpp"
-#include <algorithm>
-#include <iostream>
+#include "ExportEnv.hpp"
+#include <cctype>
+#include <filesystem>
 #include <string>
 #include <vector>
 
 namespace hyprquery {
 
-std::string envTransformKey(const std::string &key, bool isDynamic) {
-  std::string out = key;
+namespace {
+
+// Anything but [A-Za-z0-9_] would make the name an invalid identifier,
+// e.g. the `.` in general:col.active_border
+std::string identifier(std::string name) {
+  for (char &c : name) {
+    unsigned char uc = static_cast<unsigned char>(c);
+    if (!(uc < 0x80 && (std::isalnum(uc) || c == '_')))
+      c = '_';
+  }
+  return name;
+}
+
+} // namespace
 
-  std::replace(out.begin(), out.end(), ':', '_');
-  std::replace(out.begin(), out.end(), '-', '_');
+std::string envTransformKey(const std::string &key, bool isDynamic) {
+  std::string out = identifier(key);
 
   if (isDynamic) {
     out = "__" + out;
@@ -20,13 +32,23 @@ std::string envTransformKey(const std::string &key, bool isDynamic) {
   return out;
 }
 
-void exportEnv(const std::vector<QueryResult> &results,
-               const std::vector<hyprquery::QueryInput> &queries) {
-  for (size_t i = 0; i < results.size(); ++i) {
-    const auto &result = results[i];
-    const auto &query = queries[i];
-    std::string envKey = envTransformKey(query.query, query.isDynamicVariable);
-    std::cout << envKey << "=\"" << result.value << "\"\n";
+void exportEnv(OutputWriter &out, const std::vector<QueryResult> &results) {
+  for (const auto &result : results) {
+    // Results carry their own key, so expanded wildcard queries export one
+    // variable per match
+    bool isDynamic = !result.key.empty() && result.key[0] == '$';
+    std::string envKey =
+        envTransformKey(isDynamic ? result.key.substr(1) : result.key,
+                        isDynamic);
+    // Results of several configs are told apart by the config's name,
+    // e.g. hyprlock_general_grace
+    if (!result.file.empty())
+      out.append(
+          identifier(std::filesystem::path(result.file).stem().string()));
+    out.append(envKey);
+    out.append('=');
+    out.appendShellQuoted(ValueText(result.value));
+    out.append('\n');
   }
 }
 
@@ -1,9 +1,10 @@
 #pragma once
 #include "ConfigUtils.hpp"
+#include "OutputWriter.hpp"
 
 #include <vector>
 
 namespace hyprquery {
-void exportEnv(const std::vector<QueryResult> &results,
-               const std::vector<QueryInput> &queries);
+// KEY="value" lines that a POSIX shell can eval or source
+void exportEnv(OutputWriter &out, const std::vector<QueryResult> &results);
 }
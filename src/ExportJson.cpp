@@ -1,20 +1,205 @@
-#include "ConfigUtils.hpp"
-#include <iostream>
-#include <nlohmann/json.hpp>
-
-#include <vector>
+#include "ExportJson.hpp"
 
 namespace hyprquery {
 
-void exportJson(const std::vector<QueryResult> &results) {
-  nlohmann::json jsonArr = nlohmann::json::array();
-  for (const auto &result : results) {
-    jsonArr.push_back({{"key", result.key},
-                       {"val", result.value},
-                       {"type", result.type},
-                       {"flags", result.flags}});
+namespace {
+
+// One element per line when pretty, like nlohmann::json::dump(2)
+template <typename Element>
+void writeArray(OutputWriter &out, size_t size, std::string_view indent,
+                Element &&element) {
+  if (size == 0) {
+    out.append("[]");
+    return;
+  }
+  const bool pretty = !indent.empty();
+  out.append(pretty ? "[\n" : "[");
+  for (size_t i = 0; i < size; ++i) {
+    if (i > 0)
+      out.append(pretty ? ",\n" : ",");
+    if (pretty) {
+      out.append(indent);
+      out.append("    ");
+    }
+    element(i);
+  }
+  if (pretty) {
+    out.append('\n');
+    out.append(indent);
+    out.append("  ");
+  }
+  out.append(']');
+}
+
+// Members of one object, in the order nlohmann::json used to sort them
+class ObjectWriter {
+public:
+  ObjectWriter(OutputWriter &out, std::string_view indent)
+      : m_out(out), m_indent(indent), m_pretty(!indent.empty()) {
+    m_out.append(m_pretty ? "{\n" : "{");
+  }
+
+  ~ObjectWriter() {
+    if (m_pretty) {
+      m_out.append('\n');
+      m_out.append(m_indent);
+    }
+    m_out.append('}');
   }
-  std::cout << jsonArr.dump(2) << std::endl;
+
+  // Writes the name; the caller writes the value
+  void member(std::string_view name) {
+    if (m_members++ > 0)
+      m_out.append(m_pretty ? ",\n" : ",");
+    if (m_pretty) {
+      m_out.append(m_indent);
+      m_out.append("  ");
+    }
+    m_out.append('"');
+    m_out.append(name);
+    m_out.append('"');
+    m_out.append(m_pretty ? ": " : ":");
+  }
+
+private:
+  OutputWriter &m_out;
+  std::string_view m_indent;
+  bool m_pretty;
+  size_t m_members = 0;
+};
+
+// Numbers as numbers, VEC2 as [x, y], a Gradient as an object of angle
+// and stops and a list as an array of entry objects, so consumers need no
+// parsing
+void writeValue(OutputWriter &out, const Value &value,
+                std::string_view indent) {
+  if (auto *text = std::get_if<std::string>(&value)) {
+    out.appendJsonString(*text);
+  } else if (std::holds_alternative<int64_t>(value)) {
+    out.append(ValueText(value));
+  } else if (auto *real = std::get_if<double>(&value)) {
+    out.appendJsonNumber(*real);
+  } else if (auto *vec = std::get_if<Vec2>(&value)) {
+    writeArray(out, 2, indent, [&](size_t i) {
+      out.appendJsonNumber(i == 0 ? vec->x : vec->y);
+    });
+  } else if (auto *gradient = std::get_if<Gradient>(&value)) {
+    std::string inner = indent.empty() ? "" : std::string(indent) + "  ";
+    ObjectWriter object(out, inner);
+    object.member("angle");
+    out.appendJsonNumber(gradient->angle);
+    object.member("stops");
+    writeArray(out, gradient->count, inner, [&](size_t i) {
+      char text[16];
+      char *end = formatColor(text, gradient->stops[i], ColorFormat::HexAlpha);
+      out.append('"');
+      out.append(std::string_view(text, end - text));
+      out.append('"');
+    });
+  } else if (auto *list = std::get_if<KeywordList>(&value)) {
+    // Entries sit one level deeper than the members of a gradient
+    std::string inner = indent.empty() ? "" : std::string(indent) + "    ";
+    const KeywordStore &store = *list->store;
+    writeArray(out, list->entries.size(), indent, [&](size_t i) {
+      uint32_t entry = list->entries[i];
+      ObjectWriter object(out, inner);
+      object.member("file");
+      out.appendJsonString(store.file(entry));
+      object.member("keyword");
+      out.appendJsonString(store.command(entry));
+      object.member("line");
+      out.append(ValueText(Value(int64_t(store.line(entry)))));
+      object.member("value");
+      out.appendJsonString(store.value(entry));
+    });
+  } else {
+    out.append("null");
+  }
+}
+
+void writeObject(OutputWriter &out, const QueryResult &result,
+                 std::string_view indent) {
+  ObjectWriter object(out, indent);
+  if (!result.file.empty()) {
+    object.member("file");
+    out.appendJsonString(result.file);
+  }
+  object.member("flags");
+  writeArray(out, result.flags.size(), indent,
+             [&](size_t i) { out.appendJsonString(result.flags[i]); });
+  object.member("key");
+  out.appendJsonString(result.key);
+  object.member("type");
+  out.appendJsonString(result.type);
+  object.member("val");
+  writeValue(out, result.value, indent);
+}
+
+void writeObject(OutputWriter &out, const Violation &violation,
+                 std::string_view indent) {
+  ObjectWriter object(out, indent);
+  object.member("file");
+  out.appendJsonString(violation.file);
+  object.member("key");
+  if (violation.key.empty())
+    out.append("null");
+  else
+    out.appendJsonString(violation.key);
+  object.member("kind");
+  out.appendJsonString(violation.kind);
+  object.member("line");
+  out.append(ValueText(Value(int64_t(violation.line))));
+  object.member("message");
+  out.appendJsonString(violation.message);
+  object.member("val");
+  writeValue(out, violation.value, indent);
+}
+
+template <typename Item>
+void writeJson(OutputWriter &out, const std::vector<Item> &items,
+               bool compact) {
+  if (items.empty()) {
+    out.append("[]\n");
+    return;
+  }
+  out.append(compact ? "[" : "[\n");
+  for (size_t i = 0; i < items.size(); ++i) {
+    if (i > 0)
+      out.append(compact ? "," : ",\n");
+    if (!compact)
+      out.append("  ");
+    writeObject(out, items[i], compact ? "" : "  ");
+  }
+  out.append(compact ? "]\n" : "\n]\n");
+}
+
+template <typename Item>
+void writeNdjson(OutputWriter &out, const std::vector<Item> &items) {
+  for (const auto &item : items) {
+    writeObject(out, item, "");
+    out.append('\n');
+  }
+}
+
+} // namespace
+
+void exportJson(OutputWriter &out, const std::vector<QueryResult> &results,
+                bool compact) {
+  writeJson(out, results, compact);
+}
+
+void exportNdjson(OutputWriter &out, const std::vector<QueryResult> &results) {
+  writeNdjson(out, results);
+}
+
+void exportJson(OutputWriter &out, const std::vector<Violation> &violations,
+                bool compact) {
+  writeJson(out, violations, compact);
+}
+
+void exportNdjson(OutputWriter &out,
+                  const std::vector<Violation> &violations) {
+  writeNdjson(out, violations);
 }
 
 } // namespace hyprquery
@@ -1,7 +1,21 @@
 #pragma once
 #include "ConfigUtils.hpp"
+#include "OutputWriter.hpp"
+#include "Validator.hpp"
 #include <vector>
 
 namespace hyprquery {
-void exportJson(const std::vector<QueryResult> &results);
-}
+// A JSON array of {flags, key, type, val} objects, indented by two spaces
+// unless compact; results of a multi-config query also carry their file
+void exportJson(OutputWriter &out, const std::vector<QueryResult> &results,
+                bool compact = false);
+
+// One compact JSON object per result and line
+void exportNdjson(OutputWriter &out, const std::vector<QueryResult> &results);
+
+// The same for a --validate report: {file, key, kind, line, message, val}
+void exportJson(OutputWriter &out, const std::vector<Violation> &violations,
+                bool compact = false);
+void exportNdjson(OutputWriter &out,
+                  const std::vector<Violation> &violations);
+} // namespace hyprquery
@@ -0,0 +1,259 @@
+#include "FastPath.hpp"
+#include "InputFiles.hpp"
+#include "Profiler.hpp"
+#include <cctype>
+#include <cstring>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+#include <unordered_map>
+
+extern char **environ;
+
+namespace hyprquery {
+
+namespace {
+
+std::string_view trim(std::string_view str) {
+  size_t start = str.find_first_not_of(" \t");
+  if (start == std::string_view::npos)
+    return {};
+  size_t end = str.find_last_not_of(" \t");
+  return str.substr(start, end - start + 1);
+}
+
+bool isCategoryName(std::string_view name) {
+  if (name.empty())
+    return false;
+  for (char c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' &&
+        c != '-' && c != '.')
+      return false;
+  }
+  return true;
+}
+
+// hyprlang expands the environment into a value as well, and a variable
+// whose name starts the queried one could take its place
+bool environmentShadows(std::string_view name) {
+  for (char **env = environ; *env; ++env) {
+    const char *equals = strchr(*env, '=');
+    if (!equals)
+      continue;
+    std::string_view envName(*env, equals - *env);
+    if (envName.size() < name.size() && name.starts_with(envName))
+      return true;
+  }
+  return false;
+}
+
+class Scanner {
+public:
+  Scanner(const EngineOptions &options, const std::vector<QueryInput> &queries)
+      : m_options(options), m_keywords(options.keywords) {
+    for (const auto &query : queries) {
+      if (query.isDynamicVariable)
+        m_variables.try_emplace(query.query.substr(1));
+      else
+        m_keys.try_emplace(query.query);
+    }
+  }
+
+  // False as soon as a line needs the full parse
+  bool scan(std::string_view text) {
+    size_t lineNumber = 0;
+    const char *cursor = text.data();
+    const char *end = text.data() + text.size();
+    while (cursor < end) {
+      ++lineNumber;
+      auto *newline = static_cast<const char *>(
+          memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+      const char *lineEnd = newline ? newline : end;
+      std::string_view raw(cursor, static_cast<size_t>(lineEnd - cursor));
+      cursor = newline ? newline + 1 : end;
+      if (!scanLine(raw, lineNumber)) {
+        spdlog::debug("[fast-path] Line {} needs the full parse", lineNumber);
+        return false;
+      }
+    }
+    return m_categoryStarts.empty();
+  }
+
+  std::optional<FastPathOutcome>
+  answer(const std::vector<QueryInput> &queries) {
+    FastPathOutcome outcome;
+    outcome.parseError = std::move(m_parseError);
+    for (const auto &query : queries) {
+      QueryResult result;
+      result.key = query.query;
+      if (query.isDynamicVariable) {
+        // An undefined name is expanded from the environment or left as is
+        const auto &value = m_variables.at(query.query.substr(1));
+        if (!value)
+          return std::nullopt;
+        result.value = *value;
+      } else {
+        // Queried keys are STRING placeholders that default to ""
+        const auto &value = m_keys.at(query.query);
+        result.value = value.value_or(std::string());
+      }
+      result.type = "STRING";
+      applyQueryFilters(result, query);
+      outcome.results.push_back(std::move(result));
+      Profiler::count(ProfileCounter::QueriesExecuted);
+    }
+    return outcome;
+  }
+
+private:
+  bool scanLine(std::string_view raw, size_t lineNumber) {
+    if (raw.find('\r') != std::string_view::npos)
+      return false;
+    std::string_view line = trim(raw);
+    if (line.empty())
+      return true;
+    // A line starting with `#` is a comment even when it is `##`, unless it
+    // is a `# hyprlang` directive
+    if (line.front() == '#')
+      return line.find("hyprlang") == std::string_view::npos;
+    // Past the first column `#` starts a comment and `##` is a literal `#`
+    if (line.find('#') != std::string_view::npos) {
+      m_line.clear();
+      for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] != '#') {
+          m_line.push_back(line[i]);
+          continue;
+        }
+        if (i + 1 == line.size() || line[i + 1] != '#')
+          break;
+        // hyprlang skips the character after an escape when it looks for
+        // the next `#`, so `###` is not what it seems
+        if (i + 2 < line.size() && line[i + 2] == '#')
+          return false;
+        m_line.push_back('#');
+        ++i;
+      }
+      line = trim(m_line);
+      if (line.empty())
+        return true;
+    }
+
+    size_t equals = line.find('=');
+    if (equals == std::string_view::npos) {
+      if (line == "}") {
+        if (m_categoryStarts.empty())
+          return false;
+        m_categories.resize(m_categoryStarts.back());
+        m_categoryStarts.pop_back();
+        return true;
+      }
+      if (line.back() != '{')
+        return false;
+      std::string_view name = trim(line.substr(0, line.size() - 1));
+      // Special categories are keyed with [name] or by a key inside them
+      if (!isCategoryName(name))
+        return false;
+      m_categoryStarts.push_back(m_categories.size());
+      m_categories += name;
+      m_categories += ':';
+      return true;
+    }
+
+    std::string_view lhs = trim(line.substr(0, equals));
+    std::string_view rhs = trim(line.substr(equals + 1));
+    // Braces next to `=` are expressions or categories hyprlang reads its
+    // own way
+    if (lhs.empty() || line.find_first_of("{}") != std::string_view::npos)
+      return false;
+    if (lhs.front() == '$') {
+      auto it = m_variables.find(std::string(lhs.substr(1)));
+      if (it != m_variables.end()) {
+        // Redefining a variable a value expands re-evaluates that value
+        if (rhs.find('$') != std::string_view::npos)
+          return false;
+        it->second = std::string(rhs);
+      }
+      return true;
+    }
+    if (lhs.find('$') != std::string_view::npos)
+      return false;
+
+    // Keyword lines go to their handler; inside a category hyprlang may
+    // scope them differently
+    if (m_keywords.match(lhs) >= 0)
+      return m_categories.empty();
+
+    m_key = m_categories;
+    m_key += lhs;
+    if (m_key == "source" && m_options.followSource)
+      return false;
+    auto it = m_keys.find(m_key);
+    if (it == m_keys.end()) {
+      // Only queried keys are registered; hyprlang keeps the first error
+      if (m_parseError.empty())
+        m_parseError = fmt::format(
+            "Config error in file {} at line {}: config option <{}> does not "
+            "exist.",
+            m_options.configPath, lineNumber, m_key);
+      return true;
+    }
+    if (rhs.find('$') != std::string_view::npos)
+      return false;
+    it->second = std::string(rhs);
+    return true;
+  }
+
+  const EngineOptions &m_options;
+  KeywordSet m_keywords;
+  // Queried keys and variables without the `$`, with their last value
+  std::unordered_map<std::string, std::optional<std::string>> m_keys;
+  std::unordered_map<std::string, std::optional<std::string>> m_variables;
+  std::string m_categories;
+  std::vector<size_t> m_categoryStarts;
+  std::string m_line;
+  std::string m_key;
+  std::string m_parseError;
+};
+
+} // namespace
+
+bool FastPath::eligible(const EngineOptions &options,
+                        const std::vector<QueryInput> &queries) {
+  // Schema options are typed and have defaults, only a parse knows both
+  if (!options.fastPath || !options.schemaPath.empty() ||
+      options.builtinSchema || options.getDefaults || options.dumpAll ||
+      options.validate || options.incremental || queries.empty())
+    return false;
+  KeywordSet keywords(options.keywords);
+  for (const auto &query : queries) {
+    // Keyword lists carry the file and line of every entry
+    if (query.isPattern || query.query.empty() ||
+        keywords.match(query.query) >= 0)
+      return false;
+    if (query.isDynamicVariable &&
+        (query.query.size() == 1 ||
+         environmentShadows(std::string_view(query.query).substr(1))))
+      return false;
+  }
+  return true;
+}
+
+std::optional<FastPathOutcome>
+FastPath::run(const EngineOptions &options,
+              const std::vector<QueryInput> &queries) {
+  if (!eligible(options, queries))
+    return std::nullopt;
+  ProfileSpan span("fast path");
+  auto file = InputFiles::map(options.configPath);
+  if (!file->isOpen())
+    return std::nullopt;
+  Scanner scanner(options, queries);
+  if (!scanner.scan(file->view()))
+    return std::nullopt;
+  auto outcome = scanner.answer(queries);
+  if (outcome)
+    spdlog::debug("[fast-path] Answered {} queries without parsing",
+                  queries.size());
+  return outcome;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ConfigUtils.hpp"
+#include "QueryEngine.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace hyprquery {
+
+struct FastPathOutcome {
+  std::vector<QueryResult> results;
+  // The first error hyprlang would report, in its words
+  std::string parseError;
+};
+
+// Answers plain key and $VARIABLE queries straight from the mapped text of
+// a config, without a Hyprlang::CConfig, schema registration or a parse.
+// It understands categories, a:b:c keys, comments and last-assignment-wins,
+// skips top-level keyword lines, and gives up on anything else: source=
+// that has to be followed, expressions, values that expand variables,
+// hyprlang directives and lines hyprlang would reject in other ways.
+class FastPath {
+public:
+  // Whether the options and queries allow it at all, before reading
+  static bool eligible(const EngineOptions &options,
+                       const std::vector<QueryInput> &queries);
+
+  // The results a full parse would give, or nothing when the config needs
+  // one
+  static std::optional<FastPathOutcome>
+  run(const EngineOptions &options, const std::vector<QueryInput> &queries);
+};
+
+} // namespace hyprquery
@@ -0,0 +1,133 @@
+#include "FileWatcher.hpp"
+#include "ConfigCache.hpp"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                                IN_CREATE | IN_DELETE | IN_ATTRIB |
+                                IN_DELETE_SELF | IN_MOVE_SELF;
+
+std::string normalized(const std::string &path) {
+  return std::filesystem::path(path).lexically_normal().string();
+}
+
+} // namespace
+
+FileWatcher::FileWatcher() {
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0)
+    spdlog::error("inotify_init1 failed: {}", strerror(errno));
+}
+
+FileWatcher::~FileWatcher() {
+  if (m_fd >= 0)
+    close(m_fd);
+}
+
+void FileWatcher::watch(const std::vector<FileStamp> &dependencies) {
+  std::vector<std::string> files;
+  std::vector<std::string> directories;
+  for (const auto &dep : dependencies) {
+    if (dep.kind == FileStamp::Kind::Directory)
+      directories.push_back(dep.path);
+    else
+      files.push_back(dep.path);
+  }
+  setPaths(files, directories);
+  spdlog::debug("[watch] Watching {} files and {} directories", files.size(),
+                directories.size());
+}
+
+void FileWatcher::setPaths(const std::vector<std::string> &files,
+                           const std::vector<std::string> &directories) {
+  if (m_fd < 0)
+    return;
+
+  m_files.clear();
+  m_directories.clear();
+  std::unordered_set<std::string> wanted;
+  auto addFile = [&](const std::string &path) {
+    std::string file = normalized(path);
+    m_files.insert(file);
+    wanted.insert(std::filesystem::path(file).parent_path().string());
+  };
+  for (const auto &file : files) {
+    addFile(file);
+    // Follow symlinked configs to the directory the real file lives in
+    std::error_code ec;
+    auto target = std::filesystem::weakly_canonical(file, ec);
+    if (!ec && target.string() != normalized(file))
+      addFile(target.string());
+  }
+  for (const auto &dir : directories) {
+    m_directories.insert(normalized(dir));
+    wanted.insert(normalized(dir));
+  }
+
+  for (auto it = m_watchDescriptors.begin(); it != m_watchDescriptors.end();) {
+    if (wanted.contains(it->first)) {
+      ++it;
+      continue;
+    }
+    inotify_rm_watch(m_fd, it->second);
+    m_watchDirs.erase(it->second);
+    it = m_watchDescriptors.erase(it);
+  }
+  for (const auto &dir : wanted) {
+    if (m_watchDescriptors.contains(dir))
+      continue;
+    int wd = inotify_add_watch(m_fd, dir.c_str(), WATCH_MASK);
+    if (wd < 0) {
+      spdlog::debug("[watch] Cannot watch {}: {}", dir, strerror(errno));
+      continue;
+    }
+    m_watchDescriptors[dir] = wd;
+    m_watchDirs[wd] = dir;
+  }
+}
+
+bool FileWatcher::readEvents() {
+  alignas(struct inotify_event) char buffer[4096];
+  bool relevant = false;
+  while (true) {
+    ssize_t len = read(m_fd, buffer, sizeof(buffer));
+    if (len <= 0)
+      break;
+    for (char *ptr = buffer; ptr < buffer + len;) {
+      const auto *event = reinterpret_cast<const struct inotify_event *>(ptr);
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      auto dirIt = m_watchDirs.find(event->wd);
+      if (dirIt == m_watchDirs.end())
+        continue;
+      const std::string &dir = dirIt->second;
+      if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF)) {
+        relevant = true;
+        if (event->mask & IN_IGNORED) {
+          m_watchDescriptors.erase(dir);
+          m_watchDirs.erase(dirIt);
+        }
+        continue;
+      }
+      if (m_directories.contains(dir)) {
+        relevant = true;
+        continue;
+      }
+      if (event->len > 0 && m_files.contains(dir + "/" + event->name)) {
+        spdlog::debug("[watch] {}/{} changed", dir, event->name);
+        relevant = true;
+      }
+    }
+  }
+  return relevant;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace hyprquery {
+
+struct FileStamp;
+
+// inotify watch over a set of files and directories. Files are watched
+// through their parent directory so that editors replacing a file by
+// rename are noticed as well.
+class FileWatcher {
+public:
+  FileWatcher();
+  ~FileWatcher();
+
+  FileWatcher(const FileWatcher &) = delete;
+  FileWatcher &operator=(const FileWatcher &) = delete;
+
+  bool isValid() const { return m_fd >= 0; }
+  int fd() const { return m_fd; }
+
+  // Replace the watched set; any change inside one of the directories
+  // counts, for files only events naming that file do
+  void setPaths(const std::vector<std::string> &files,
+                const std::vector<std::string> &directories);
+
+  // Watch every file and directory a parse recorded; the source graph may
+  // have changed since the last call
+  void watch(const std::vector<FileStamp> &dependencies);
+
+  // Drain pending events; true if one of them touched a watched path
+  bool readEvents();
+
+private:
+  std::unordered_map<int, std::string> m_watchDirs;
+  std::unordered_map<std::string, int> m_watchDescriptors;
+  std::unordered_set<std::string> m_files;
+  std::unordered_set<std::string> m_directories;
+  int m_fd = -1;
+};
+
+} // namespace hyprquery
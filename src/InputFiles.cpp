@@ -0,0 +1,62 @@
+#include "InputFiles.hpp"
+#include "Profiler.hpp"
+#include <sys/stat.h>
+
+namespace hyprquery {
+
+namespace {
+
+thread_local InputFiles *t_files = nullptr;
+
+InputFiles::Mapping mapNow(const std::string &path) {
+  auto mapping = std::make_shared<const MappedFile>(path);
+  if (mapping->isOpen()) {
+    Profiler::count(ProfileCounter::FilesMapped);
+    Profiler::count(ProfileCounter::BytesMapped, mapping->size());
+  }
+  return mapping;
+}
+
+} // namespace
+
+InputFiles::Scope::Scope() : m_previous(t_files) {
+  if (!t_files) {
+    m_owned = std::make_unique<InputFiles>();
+    t_files = m_owned.get();
+  }
+}
+
+InputFiles::Scope::Scope(InputFiles *files) : m_previous(t_files) {
+  if (files)
+    t_files = files;
+}
+
+InputFiles::Scope::~Scope() { t_files = m_previous; }
+
+InputFiles *InputFiles::current() { return t_files; }
+
+InputFiles::Mapping InputFiles::map(const std::string &path) {
+  return t_files ? t_files->get(path) : mapNow(path);
+}
+
+InputFiles::Mapping InputFiles::get(const std::string &path) {
+  Profiler::count(ProfileCounter::StatCalls);
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    return std::make_shared<const MappedFile>();
+  int64_t mtimeNs = int64_t(st.st_mtim.tv_sec) * 1000000000 +
+                    st.st_mtim.tv_nsec;
+
+  std::lock_guard lock(m_mutex);
+  Entry &entry = m_files[{st.st_dev, st.st_ino}];
+  if (entry.mapping && entry.size == st.st_size && entry.mtimeNs == mtimeNs) {
+    Profiler::count(ProfileCounter::MappingsShared);
+    return entry.mapping;
+  }
+  // A file that changed is mapped again; readers of the old mapping keep
+  // it alive until they are done
+  entry = {st.st_size, mtimeNs, mapNow(path)};
+  return entry.mapping;
+}
+
+} // namespace hyprquery
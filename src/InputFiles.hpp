@@ -0,0 +1,61 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <utility>
+
+namespace hyprquery {
+
+// Mappings of the config files hyq reads itself: the key scanner, the
+// prefetcher, the source graph, the fast path and snapshots. Within a
+// Scope every file is mapped once, however many times it is sourced or
+// scanned and under whichever path, and readers get views into the same
+// pages. A mapping is reused only while stat() still reports the same
+// inode, size and mtime. Outside of a Scope every call maps the file anew.
+class InputFiles {
+public:
+  using Mapping = std::shared_ptr<const MappedFile>;
+
+  // Shares mappings on this thread until destroyed. A Scope inside another
+  // one on the same thread joins it; a worker thread joins the scope of
+  // the thread it works for through current().
+  class Scope {
+  public:
+    Scope();
+    explicit Scope(InputFiles *files);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    std::unique_ptr<InputFiles> m_owned;
+    InputFiles *m_previous;
+  };
+
+  // Never null; not open when the file can not be read
+  static Mapping map(const std::string &path);
+
+  // The mappings of the innermost Scope on this thread, or null
+  static InputFiles *current();
+
+private:
+  struct Entry {
+    off_t size = 0;
+    int64_t mtimeNs = 0;
+    Mapping mapping;
+  };
+
+  Mapping get(const std::string &path);
+
+  std::mutex m_mutex;
+  // By device and inode, so that two paths to one file share its mapping
+  std::map<std::pair<dev_t, ino_t>, Entry> m_files;
+};
+
+} // namespace hyprquery
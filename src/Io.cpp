@@ -0,0 +1,45 @@
+#include "Io.hpp"
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace hyprquery {
+
+namespace {
+
+volatile sig_atomic_t g_stopRequested = 0;
+
+void onStopSignal(int) { g_stopRequested = 1; }
+
+} // namespace
+
+bool writeAll(int fd, std::string_view data) {
+  bool socket = true;
+  while (!data.empty()) {
+    ssize_t n = socket ? send(fd, data.data(), data.size(), MSG_NOSIGNAL)
+                       : write(fd, data.data(), data.size());
+    if (n < 0 && errno == ENOTSOCK && socket) {
+      socket = false;
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data.remove_prefix(static_cast<size_t>(n));
+  }
+  return true;
+}
+
+void catchStopSignals() {
+  struct sigaction action{};
+  action.sa_handler = onStopSignal;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+}
+
+bool stopRequested() { return g_stopRequested; }
+
+} // namespace hyprquery
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string_view>
+
+namespace hyprquery {
+
+// Write all of data to a blocking descriptor, retrying on EINTR. Sockets
+// are written with MSG_NOSIGNAL, so a client that went away is an error
+// and not a SIGPIPE.
+bool writeAll(int fd, std::string_view data);
+
+// Make SIGINT and SIGTERM set the flag stopRequested() reports, so that
+// the poll loops of --daemon and --watch return and clean up
+void catchStopSignals();
+bool stopRequested();
+
+} // namespace hyprquery
@@ -0,0 +1,87 @@
+#include "IoPrefetcher.hpp"
+#include "ConfigScanner.hpp"
+#include "InputFiles.hpp"
+#include <fcntl.h>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hyprquery {
+
+IoPrefetcher::IoPrefetcher(size_t workers)
+    : m_inputs(InputFiles::current()) {
+  for (size_t i = 0; i < workers; ++i)
+    m_workers.emplace_back([this] { worker(); });
+}
+
+IoPrefetcher::~IoPrefetcher() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_stopping = true;
+    m_queue.clear();
+  }
+  m_cv.notify_all();
+  for (auto &thread : m_workers)
+    thread.join();
+  spdlog::debug("[prefetch] Read ahead {} files, {} bytes", m_files.load(),
+                m_bytes.load());
+}
+
+void IoPrefetcher::prefetch(const std::string &path, bool followSources) {
+  if (m_workers.empty())
+    return;
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_stopping || !m_seen.insert(path).second)
+      return;
+    m_queue.push_back({path, followSources});
+  }
+  m_cv.notify_one();
+}
+
+void IoPrefetcher::worker() {
+  // Files scanned for source= lines are mapped once for the whole parse
+  InputFiles::Scope inputs(m_inputs);
+  while (true) {
+    Job job;
+    {
+      std::unique_lock lock(m_mutex);
+      m_cv.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+      if (m_stopping)
+        return;
+      job = std::move(m_queue.front());
+      m_queue.pop_front();
+    }
+    load(job);
+  }
+}
+
+void IoPrefetcher::load(const Job &job) {
+  int fd = open(job.path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return;
+  }
+  // readahead() returns once the pages are cached, which is the blocking
+  // read taken off the parsing thread
+  if (readahead(fd, 0, st.st_size) != 0)
+    posix_fadvise(fd, 0, st.st_size, POSIX_FADV_WILLNEED);
+  close(fd);
+  ++m_files;
+  m_bytes += st.st_size;
+
+  if (!job.followSources)
+    return;
+  auto file = InputFiles::map(job.path);
+  if (!file->isOpen())
+    return;
+  std::string dir = std::filesystem::path(job.path).parent_path().string();
+  for (const auto &path : ConfigScanner::sourcedFiles(file->view(), dir))
+    prefetch(path, true);
+}
+
+} // namespace hyprquery
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace hyprquery {
+
+class InputFiles;
+
+// Small worker pool that pulls config files into the page cache ahead of
+// the parser. Files are only read ahead, never parsed, so hyprlang still
+// applies them in source order on the calling thread. Workers share the
+// InputFiles scope of the thread that creates the pool.
+class IoPrefetcher {
+public:
+  explicit IoPrefetcher(size_t workers);
+  ~IoPrefetcher();
+
+  IoPrefetcher(const IoPrefetcher &) = delete;
+  IoPrefetcher &operator=(const IoPrefetcher &) = delete;
+
+  // Queue a file once; with followSources its source= targets follow
+  void prefetch(const std::string &path, bool followSources = false);
+
+private:
+  struct Job {
+    std::string path;
+    bool followSources;
+  };
+
+  void worker();
+  void load(const Job &job);
+
+  InputFiles *m_inputs;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<Job> m_queue;
+  std::unordered_set<std::string> m_seen;
+  std::vector<std::thread> m_workers;
+  bool m_stopping = false;
+  std::atomic<size_t> m_files = 0;
+  std::atomic<uint64_t> m_bytes = 0;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,39 @@
+#include "KeyIndex.hpp"
+#include <algorithm>
+#include <fnmatch.h>
+
+namespace hyprquery {
+
+bool isKeyPattern(std::string_view query) {
+  if (query.empty())
+    return false;
+  // Variables have no categories, only globs
+  if (query[0] == '$')
+    return query.find_first_of("*?") != std::string_view::npos;
+  return query.find_first_of("*?") != std::string_view::npos ||
+         query.back() == ':';
+}
+
+void KeyIndex::finalize() {
+  std::sort(m_keys.begin(), m_keys.end());
+  m_keys.erase(std::unique(m_keys.begin(), m_keys.end()), m_keys.end());
+}
+
+std::vector<std::string> KeyIndex::match(std::string_view pattern) const {
+  std::string glob(pattern);
+  if (!glob.empty() && glob.back() == ':')
+    glob.push_back('*');
+  std::string_view prefix =
+      std::string_view(glob).substr(0, glob.find_first_of("*?"));
+  bool prefixOnly = glob.size() == prefix.size() + 1 && glob.back() == '*';
+
+  std::vector<std::string> matches;
+  auto it = std::lower_bound(m_keys.begin(), m_keys.end(), prefix);
+  for (; it != m_keys.end() && it->starts_with(prefix); ++it) {
+    if (prefixOnly || fnmatch(glob.c_str(), it->c_str(), 0) == 0)
+      matches.push_back(*it);
+  }
+  return matches;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery {
+
+// True for wildcard queries: `*` or `?` anywhere, or a trailing `:` that
+// asks for everything under a category. `$` patterns match variables.
+bool isKeyPattern(std::string_view query);
+
+// Sorted key set answering prefix and glob queries
+class KeyIndex {
+public:
+  void add(std::string_view key) { m_keys.emplace_back(key); }
+  // Sort and deduplicate; call once after the last add()
+  void finalize();
+
+  // Keys matching the pattern in sorted order. The scan starts at the
+  // literal prefix of the pattern, so it only visits keys sharing it.
+  std::vector<std::string> match(std::string_view pattern) const;
+
+  size_t size() const { return m_keys.size(); }
+
+private:
+  std::vector<std::string> m_keys;
+};
+
+} // namespace hyprquery
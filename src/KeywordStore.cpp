@@ -0,0 +1,182 @@
+#include "KeywordStore.hpp"
+#include "ConfigScanner.hpp"
+#include "InputFiles.hpp"
+#include "SourceHandler.hpp"
+#include <algorithm>
+#include <cctype>
+#include <hyprlang.hpp>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr uint16_t NO_FILE = UINT16_MAX;
+
+Hyprlang::CParseResult handleKeyword(const char *command, const char *value) {
+  SourceContext *context = SourceHandler::context();
+  if (context && context->keywords)
+    context->keywords->add(command, value);
+  return {};
+}
+
+} // namespace
+
+const std::vector<std::string> &defaultKeywords() {
+  static const std::vector<std::string> keywords = {
+      "bind*",      "exec",         "exec-once", "exec-shutdown",
+      "windowrule", "windowrulev2", "layerrule", "workspace",
+      "monitor",    "env"};
+  return keywords;
+}
+
+KeywordSet::KeywordSet(const std::vector<std::string> &names) {
+  for (std::string_view name : names) {
+    Keyword keyword;
+    keyword.flags = name.ends_with('*');
+    if (keyword.flags)
+      name.remove_suffix(1);
+    keyword.name = name;
+    if (keyword.name.empty() ||
+        std::any_of(m_keywords.begin(), m_keywords.end(),
+                    [&](const Keyword &k) { return k.name == name; }))
+      continue;
+    m_keywords.push_back(std::move(keyword));
+  }
+}
+
+int KeywordSet::match(std::string_view lhs) const {
+  for (size_t i = 0; i < m_keywords.size(); ++i) {
+    if (m_keywords[i].name == lhs)
+      return static_cast<int>(i);
+  }
+  for (size_t i = 0; i < m_keywords.size(); ++i) {
+    const Keyword &keyword = m_keywords[i];
+    if (keyword.flags && lhs.starts_with(keyword.name) &&
+        std::all_of(lhs.begin() + keyword.name.size(), lhs.end(), [](char c) {
+          return std::isalpha(static_cast<unsigned char>(c));
+        }))
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void KeywordSet::registerHandlers(Hyprlang::CConfig &config) const {
+  for (const auto &keyword : m_keywords) {
+    Hyprlang::SHandlerOptions options;
+    options.allowFlags = keyword.flags;
+    config.registerHandler(&handleKeyword, keyword.name.c_str(), options);
+  }
+}
+
+KeywordStore::KeywordStore(KeywordSet keywords)
+    : m_keywords(std::move(keywords)) {}
+
+std::vector<KeywordStore::KeywordLine>
+KeywordStore::keywordLines(const std::string &path) const {
+  std::vector<KeywordLine> lines;
+  auto file = InputFiles::map(path);
+  ConfigScanner::scan(file->view(), [&](const ScannedLine &line) {
+    // Keys inside a category are prefixed and never match a handler
+    if (!line.isVariable && m_keywords.match(line.key) >= 0)
+      lines.push_back({static_cast<uint32_t>(line.lineNumber),
+                       std::string(line.key), std::string(line.value)});
+  });
+  return lines;
+}
+
+uint16_t KeywordStore::intern(std::vector<std::string> &names,
+                              std::string_view name) {
+  auto it = std::find(names.begin(), names.end(), name);
+  if (it != names.end())
+    return static_cast<uint16_t>(it - names.begin());
+  names.emplace_back(name);
+  return static_cast<uint16_t>(names.size() - 1);
+}
+
+void KeywordStore::enter(const std::string &path) {
+  auto [it, inserted] = m_fileIndex.try_emplace(path, NO_FILE);
+  if (inserted && m_files.size() < NO_FILE) {
+    it->second = static_cast<uint16_t>(m_files.size());
+    m_files.push_back({path, keywordLines(path)});
+  }
+  m_visits.push_back({it->second});
+}
+
+void KeywordStore::leave() {
+  if (!m_visits.empty())
+    m_visits.pop_back();
+}
+
+void KeywordStore::add(std::string_view command, std::string_view value) {
+  int keyword = m_keywords.match(command);
+  if (keyword < 0)
+    return;
+  Entry entry{};
+  entry.value = static_cast<uint32_t>(m_text.size());
+  entry.length = static_cast<uint32_t>(value.size());
+  entry.keyword = static_cast<uint16_t>(keyword);
+  entry.command = intern(m_commands, command);
+  entry.file = NO_FILE;
+  m_text.append(value);
+  if (!m_visits.empty() && m_visits.back().file != NO_FILE) {
+    Visit &visit = m_visits.back();
+    const auto &lines = m_files[visit.file].lines;
+    entry.file = visit.file;
+    auto it = std::find_if(
+        lines.begin() + static_cast<ptrdiff_t>(visit.next), lines.end(),
+        [&](const KeywordLine &line) {
+          return line.command == command &&
+                 (line.value == value ||
+                  line.value.find('$') != std::string::npos);
+        });
+    // Without a match the scan missed the line; the next capture may
+    // still find its own
+    if (it != lines.end()) {
+      entry.line = it->number;
+      visit.next = static_cast<size_t>(it - lines.begin()) + 1;
+    }
+  }
+  m_entries.push_back(entry);
+}
+
+const std::string &KeywordStore::file(uint32_t entry) const {
+  static const std::string unknown;
+  uint16_t file = m_entries[entry].file;
+  return file == NO_FILE ? unknown : m_files[file].path;
+}
+
+std::vector<uint32_t> KeywordStore::select(std::string_view query) const {
+  std::vector<uint32_t> entries;
+  int keyword = m_keywords.match(query);
+  if (keyword < 0)
+    return entries;
+  const bool everyFlag = m_keywords.name(keyword) == query;
+  for (uint32_t i = 0; i < m_entries.size(); ++i) {
+    if (m_entries[i].keyword == keyword &&
+        (everyFlag || command(i) == query))
+      entries.push_back(i);
+  }
+  return entries;
+}
+
+bool KeywordStore::touches(const std::string &path) const {
+  auto it = m_fileIndex.find(path);
+  if (it != m_fileIndex.end() &&
+      std::any_of(m_entries.begin(), m_entries.end(),
+                  [&](const Entry &entry) { return entry.file == it->second; }))
+    return true;
+  return !keywordLines(path).empty();
+}
+
+bool KeywordList::operator==(const KeywordList &other) const {
+  if (entries.size() != other.entries.size())
+    return false;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (store->command(entries[i]) != other.store->command(other.entries[i]) ||
+        store->value(entries[i]) != other.store->value(other.entries[i]))
+      return false;
+  }
+  return true;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Hyprlang {
+class CConfig;
+}
+
+namespace hyprquery {
+
+// bind*, exec, exec-once, exec-shutdown, windowrule, windowrulev2,
+// layerrule, workspace, monitor and env
+const std::vector<std::string> &defaultKeywords();
+
+// The repeated keywords one engine captures. `NAME*` also captures NAME
+// followed by flag letters, like bindel for bind*, as hyprlang handlers
+// with allowFlags do.
+class KeywordSet {
+public:
+  KeywordSet() = default;
+  explicit KeywordSet(const std::vector<std::string> &names);
+
+  // The keyword that a line with this left-hand side calls, -1 for none
+  int match(std::string_view lhs) const;
+
+  const std::string &name(size_t keyword) const {
+    return m_keywords[keyword].name;
+  }
+  size_t size() const { return m_keywords.size(); }
+  bool empty() const { return m_keywords.empty(); }
+
+  // Handlers that add every captured line to the KeywordStore of the parse
+  // running on the calling thread
+  void registerHandlers(Hyprlang::CConfig &config) const;
+
+private:
+  struct Keyword {
+    std::string name;
+    bool flags = false;
+  };
+
+  std::vector<Keyword> m_keywords;
+};
+
+// Every value of the captured keywords of one parse, in parse order, with
+// the file and line it came from. Values are appended to one text arena
+// and an entry is 20 bytes on top of its text, so configs with thousands
+// of binds stay small.
+class KeywordStore {
+public:
+  explicit KeywordStore(KeywordSet keywords);
+
+  const KeywordSet &keywords() const { return m_keywords; }
+
+  // Captures between enter() and leave() come from path. Lines are found
+  // by scanning the file once for keyword lines and taking the next one
+  // with the same command and value, so lines hyprlang skips, like those
+  // in a false `# hyprlang if` block, are passed over. A value with a
+  // `$` is expanded before the handler sees it; those lines match on the
+  // command alone, which is a best guess when such a line was skipped.
+  void enter(const std::string &path);
+  void leave();
+  void add(std::string_view command, std::string_view value);
+
+  // Entries a query names: every entry of a keyword for its name, or only
+  // those written with exactly these flags, like binde
+  std::vector<uint32_t> select(std::string_view query) const;
+
+  // Whether reparsing path alone would add or drop entries
+  bool touches(const std::string &path) const;
+
+  size_t size() const { return m_entries.size(); }
+  std::string_view command(uint32_t entry) const {
+    return m_commands[m_entries[entry].command];
+  }
+  std::string_view value(uint32_t entry) const {
+    return std::string_view(m_text).substr(m_entries[entry].value,
+                                           m_entries[entry].length);
+  }
+  // Empty when the capture came from outside a parse
+  const std::string &file(uint32_t entry) const;
+  // 1-based, 0 when no scanned line of the file matches the capture
+  uint32_t line(uint32_t entry) const { return m_entries[entry].line; }
+
+private:
+  struct Entry {
+    uint32_t value;
+    uint32_t length;
+    uint32_t line;
+    uint16_t keyword;
+    uint16_t command;
+    uint16_t file;
+  };
+
+  // A line that calls a captured keyword, as the scan saw it
+  struct KeywordLine {
+    uint32_t number;
+    std::string command;
+    std::string value;
+  };
+
+  struct File {
+    std::string path;
+    std::vector<KeywordLine> lines;
+  };
+
+  struct Visit {
+    uint16_t file;
+    size_t next = 0;
+  };
+
+  std::vector<KeywordLine> keywordLines(const std::string &path) const;
+  uint16_t intern(std::vector<std::string> &names, std::string_view name);
+
+  KeywordSet m_keywords;
+  std::string m_text;
+  std::vector<Entry> m_entries;
+  std::vector<std::string> m_commands;
+  std::vector<File> m_files;
+  std::unordered_map<std::string, uint16_t> m_fileIndex;
+  std::vector<Visit> m_visits;
+};
+
+// The entries one keyword query selected, for a QueryResult. The list
+// keeps the store of its parse alive, so results outlive the engine.
+struct KeywordList {
+  std::shared_ptr<const KeywordStore> store;
+  std::vector<uint32_t> entries;
+
+  // Same commands and values in the same order
+  bool operator==(const KeywordList &other) const;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,196 @@
+// The C ABI of libhyprquery, see include/hyprquery/hyprquery.h
+#include "ConfigUtils.hpp"
+#include "InputFiles.hpp"
+#include "PathCache.hpp"
+#include "QueryEngine.hpp"
+#include "SourceHandler.hpp"
+#include <filesystem>
+#include <hyprquery/hyprquery.h>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include <unordered_set>
+
+using hyprquery::QueryEngine;
+
+struct hyq_config {
+  hyprquery::EngineOptions options;
+  std::unique_ptr<QueryEngine> engine;
+  // Every key queried so far, registered again on each rebuild
+  std::vector<std::string> keys;
+  std::unordered_set<std::string> keySet;
+};
+
+struct hyq_results {
+  std::vector<hyprquery::QueryResult> results;
+  // hyq_value::text of every result
+  std::vector<std::string> texts;
+  std::vector<hyq_value> values;
+};
+
+namespace {
+
+thread_local std::string t_lastError;
+
+// Run body, turning exceptions into hyq_last_error() and fallback
+template <typename Body, typename Result>
+Result guarded(Body &&body, Result fallback) {
+  try {
+    return body();
+  } catch (const std::exception &e) {
+    t_lastError = e.what();
+  } catch (...) {
+    t_lastError = "unknown error";
+  }
+  return fallback;
+}
+
+void build(hyq_config &config) {
+  hyprquery::InputFiles::Scope inputs;
+  auto engine = std::make_unique<QueryEngine>(config.options);
+  engine->prepareConfig({}, config.keys);
+  engine->parse();
+  config.engine = std::move(engine);
+}
+
+hyq_type typeOf(const std::string &name) {
+  if (name == "INT")
+    return HYQ_TYPE_INT;
+  if (name == "FLOAT")
+    return HYQ_TYPE_FLOAT;
+  if (name == "STRING")
+    return HYQ_TYPE_STRING;
+  if (name == "VEC2")
+    return HYQ_TYPE_VEC2;
+  if (name == "NULL")
+    return HYQ_TYPE_NULL;
+  if (name == "LIST")
+    return HYQ_TYPE_LIST;
+  return HYQ_TYPE_CUSTOM;
+}
+
+hyq_value toValue(const hyprquery::QueryResult &result,
+                  const std::string &text) {
+  hyq_value value{};
+  value.key = result.key.c_str();
+  value.type = typeOf(result.type);
+  value.text = text.c_str();
+  if (auto *integer = std::get_if<int64_t>(&result.value)) {
+    value.int_value = *integer;
+  } else if (auto *real = std::get_if<double>(&result.value)) {
+    value.float_value = *real;
+  } else if (auto *vec = std::get_if<hyprquery::Vec2>(&result.value)) {
+    value.vec2[0] = vec->x;
+    value.vec2[1] = vec->y;
+  }
+  return value;
+}
+
+} // namespace
+
+extern "C" {
+
+hyq_config *hyq_open(const char *configPath, const char *schemaPath,
+                     unsigned flags) {
+  return guarded(
+      [&]() -> hyq_config * {
+        if (!configPath) {
+          t_lastError = "config_path is required";
+          return nullptr;
+        }
+        // Diagnostics are for hyq --debug, not for the embedding process
+        static std::once_flag quiet;
+        std::call_once(quiet, [] { spdlog::set_level(spdlog::level::off); });
+        auto config = std::make_unique<hyq_config>();
+        auto &options = config->options;
+        hyprquery::PathCache::Scope paths;
+        std::string path = hyprquery::ConfigUtils::normalizePath(configPath);
+        auto resolved = hyprquery::SourceHandler::resolvePath(path);
+        if (resolved.empty() ||
+            !hyprquery::PathCache::status(resolved.front()).exists) {
+          t_lastError = "Configuration file does not exist: " + path;
+          return nullptr;
+        }
+        options.configPath = resolved.front().string();
+        if (schemaPath) {
+          std::string schema =
+              hyprquery::ConfigUtils::normalizePath(schemaPath);
+          auto resolvedSchema = hyprquery::SourceHandler::resolvePath(
+              schema, resolved.front().parent_path().string());
+          if (!resolvedSchema.empty())
+            schema = resolvedSchema.front().string();
+          if (!hyprquery::PathCache::status(schema).exists) {
+            t_lastError = "Schema file does not exist: " + schema;
+            return nullptr;
+          }
+          options.schemaPath = schema;
+        }
+        options.followSource = flags & HYQ_OPEN_FOLLOW_SOURCE;
+        options.builtinSchema = flags & HYQ_OPEN_BUILTIN_SCHEMA;
+        options.lazySchema = flags & HYQ_OPEN_LAZY_SCHEMA;
+        // hyq_reload() only reparses what changed
+        options.trackDependencies = true;
+        options.incremental = true;
+        build(*config);
+        return config.release();
+      },
+      static_cast<hyq_config *>(nullptr));
+}
+
+int hyq_reload(hyq_config *config) {
+  return guarded(
+      [&] {
+        if (!config->engine->reparseChanged())
+          build(*config);
+        return 0;
+      },
+      -1);
+}
+
+const char *hyq_parse_error(const hyq_config *config) {
+  const std::string &error = config->engine->parseError();
+  return error.empty() ? nullptr : error.c_str();
+}
+
+void hyq_close(hyq_config *config) { delete config; }
+
+hyq_results *hyq_query(hyq_config *config, const char *const *queries,
+                       size_t count) {
+  return guarded(
+      [&]() -> hyq_results * {
+        std::vector<std::string> raw(queries, queries + count);
+        auto inputs = hyprquery::parseQueryInputs(raw);
+        if (!config->engine->covers(inputs)) {
+          for (const auto &input : inputs) {
+            if (config->keySet.insert(input.query).second)
+              config->keys.push_back(input.query);
+          }
+          build(*config);
+        }
+
+        auto results = std::make_unique<hyq_results>();
+        results->results = config->engine->executeQueries(inputs);
+        size_t count = results->results.size();
+        results->texts.reserve(count);
+        results->values.reserve(count);
+        for (const auto &result : results->results) {
+          results->texts.push_back(hyprquery::formatValue(result.value));
+          results->values.push_back(toValue(result, results->texts.back()));
+        }
+        return results.release();
+      },
+      static_cast<hyq_results *>(nullptr));
+}
+
+size_t hyq_results_size(const hyq_results *results) {
+  return results->values.size();
+}
+
+const hyq_value *hyq_results_at(const hyq_results *results, size_t index) {
+  return index < results->values.size() ? &results->values[index] : nullptr;
+}
+
+void hyq_results_free(hyq_results *results) { delete results; }
+
+const char *hyq_last_error(void) { return t_lastError.c_str(); }
+
+} // extern "C"
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace hyprquery {
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  bool isOpen() const { return m_open; }
+  const char *data() const { return static_cast<const char *>(m_data); }
+  size_t size() const { return m_size; }
+  std::string_view view() const { return {data(), m_size}; }
+
+private:
+  void release();
+
+  void *m_data = nullptr;
+  size_t m_size = 0;
+  bool m_open = false;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,61 @@
+#include "Output.hpp"
+#include "ExportEnv.hpp"
+#include "ExportJson.hpp"
+
+namespace hyprquery {
+
+void outputResults(OutputWriter &out, const std::vector<QueryResult> &results,
+                   const std::string &exportFormat,
+                   const std::string &delimiter, bool compact) {
+  if (exportFormat == "json") {
+    exportJson(out, results, compact);
+  } else if (exportFormat == "ndjson") {
+    exportNdjson(out, results);
+  } else if (exportFormat == "env") {
+    exportEnv(out, results);
+  } else {
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (!results[i].file.empty()) {
+        out.append(results[i].file);
+        out.append('\t');
+      }
+      if (results[i].type != "NULL")
+        out.append(ValueText(results[i].value));
+      if (i + 1 < results.size())
+        out.append(delimiter);
+    }
+    out.append('\n');
+  }
+}
+
+void outputViolations(OutputWriter &out,
+                      const std::vector<Violation> &violations,
+                      const std::string &exportFormat, bool compact) {
+  if (exportFormat == "json") {
+    exportJson(out, violations, compact);
+    return;
+  }
+  if (exportFormat == "ndjson") {
+    exportNdjson(out, violations);
+    return;
+  }
+  for (const auto &violation : violations) {
+    out.append(violation.file);
+    out.append(':');
+    if (violation.line > 0) {
+      out.append(ValueText(Value(int64_t(violation.line))));
+      out.append(':');
+    }
+    out.append(' ');
+    if (!violation.key.empty()) {
+      out.append(violation.key);
+      out.append(" = ");
+      out.append(ValueText(violation.value));
+      out.append(": ");
+    }
+    out.append(violation.message);
+    out.append('\n');
+  }
+}
+
+} // namespace hyprquery
@@ -0,0 +1,23 @@
+#pragma once
+#include "ConfigUtils.hpp"
+#include "OutputWriter.hpp"
+#include "Validator.hpp"
+
+#include <string>
+#include <vector>
+
+namespace hyprquery {
+// Write results as json, ndjson, env or delimiter-separated plain values;
+// compact puts a json array on one line. Results tagged with a file are
+// prefixed by it: a "file" member, the file's stem in env names, or the
+// file and a tab in plain output.
+void outputResults(OutputWriter &out, const std::vector<QueryResult> &results,
+                   const std::string &exportFormat,
+                   const std::string &delimiter, bool compact = false);
+
+// Write a --validate report as json, ndjson or one `file:line: key: message`
+// line per violation
+void outputViolations(OutputWriter &out,
+                      const std::vector<Violation> &violations,
+                      const std::string &exportFormat, bool compact = false);
+} // namespace hyprquery
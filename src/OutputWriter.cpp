@@ -0,0 +1,150 @@
+#include "OutputWriter.hpp"
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <unistd.h>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr char HEX[] = "0123456789abcdef";
+
+// Length of the well-formed UTF-8 sequence at the start of text, 0 if
+// there is none
+size_t utf8Length(std::string_view text) {
+  auto byte = [&](size_t i) { return static_cast<unsigned char>(text[i]); };
+  unsigned char lead = byte(0);
+  size_t length = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 0;
+  if (length == 0 || lead > 0xf4 || lead == 0xc0 || lead == 0xc1 ||
+      text.size() < length)
+    return 0;
+  for (size_t i = 1; i < length; ++i) {
+    if ((byte(i) & 0xc0) != 0x80)
+      return 0;
+  }
+  // Overlong forms, surrogates and code points past U+10FFFF
+  if ((lead == 0xe0 && byte(1) < 0xa0) || (lead == 0xed && byte(1) > 0x9f) ||
+      (lead == 0xf0 && byte(1) < 0x90) || (lead == 0xf4 && byte(1) > 0x8f))
+    return 0;
+  return length;
+}
+
+} // namespace
+
+OutputWriter::OutputWriter(int fd) : m_fd(fd), m_buffer(&m_own) {
+  m_own.reserve(FLUSH_SIZE + 4096);
+}
+
+OutputWriter::OutputWriter(std::string &target) : m_buffer(&target) {}
+
+OutputWriter::~OutputWriter() { flush(); }
+
+bool OutputWriter::flush() {
+  if (m_fd < 0)
+    return m_ok;
+  std::string_view data = m_own;
+  while (m_ok && !data.empty()) {
+    ssize_t n = write(m_fd, data.data(), data.size());
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      m_ok = false;
+    else
+      data.remove_prefix(static_cast<size_t>(n));
+  }
+  m_own.clear();
+  return m_ok;
+}
+
+void OutputWriter::appendJsonString(std::string_view text) {
+  std::string &out = *m_buffer;
+  out.push_back('"');
+  while (!text.empty()) {
+    // Copy the longest run that needs no escaping in one go
+    size_t run = 0;
+    while (run < text.size()) {
+      unsigned char c = static_cast<unsigned char>(text[run]);
+      if (c < 0x20 || c == '"' || c == '\\' || c >= 0x80)
+        break;
+      ++run;
+    }
+    out.append(text.substr(0, run));
+    text.remove_prefix(run);
+    if (text.empty())
+      break;
+
+    unsigned char c = static_cast<unsigned char>(text[0]);
+    if (c >= 0x80) {
+      size_t length = utf8Length(text);
+      if (length == 0) {
+        out += "\\ufffd";
+        length = 1;
+      } else {
+        out.append(text.substr(0, length));
+      }
+      text.remove_prefix(length);
+      continue;
+    }
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\b':
+      out += "\\b";
+      break;
+    case '\f':
+      out += "\\f";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\r':
+      out += "\\r";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      out += "\\u00";
+      out.push_back(HEX[c >> 4]);
+      out.push_back(HEX[c & 0xf]);
+    }
+    text.remove_prefix(1);
+  }
+  out.push_back('"');
+  if (out.size() >= FLUSH_SIZE)
+    flush();
+}
+
+void OutputWriter::appendJsonNumber(double value) {
+  if (!std::isfinite(value)) {
+    append("null");
+    return;
+  }
+  char buffer[32];
+  char *end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+  std::string_view text(buffer, end - buffer);
+  append(text);
+  if (text.find_first_of(".e") == std::string_view::npos)
+    append(".0");
+}
+
+void OutputWriter::appendShellQuoted(std::string_view text) {
+  std::string &out = *m_buffer;
+  out.push_back('"');
+  for (char c : text) {
+    // The only characters that stay special inside double quotes
+    if (c == '"' || c == '\\' || c == '$' || c == '`')
+      out.push_back('\\');
+    out.push_back(c);
+  }
+  out.push_back('"');
+  if (out.size() >= FLUSH_SIZE)
+    flush();
+}
+
+} // namespace hyprquery
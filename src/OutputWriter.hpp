@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace hyprquery {
+
+// Append-only output buffer for the exporters. Text is escaped straight
+// into one buffer that is handed to write(2) in large chunks, or kept in
+// a caller's string.
+class OutputWriter {
+public:
+  // Write to fd whenever the buffer fills up and on flush()
+  explicit OutputWriter(int fd);
+  // Append everything to target; flush() is a no-op
+  explicit OutputWriter(std::string &target);
+  ~OutputWriter();
+
+  OutputWriter(const OutputWriter &) = delete;
+  OutputWriter &operator=(const OutputWriter &) = delete;
+
+  void append(std::string_view text) {
+    m_buffer->append(text);
+    if (m_buffer->size() >= FLUSH_SIZE)
+      flush();
+  }
+  void append(char c) {
+    m_buffer->push_back(c);
+    if (m_buffer->size() >= FLUSH_SIZE)
+      flush();
+  }
+
+  // A JSON string literal; invalid UTF-8 is replaced by U+FFFD
+  void appendJsonString(std::string_view text);
+
+  // A double the way nlohmann::json writes one: shortest round-trip, ".0"
+  // on integral values and null when not finite
+  void appendJsonNumber(double value);
+
+  // A double-quoted POSIX shell word that expands to exactly text
+  void appendShellQuoted(std::string_view text);
+
+  // False once a write to the fd failed
+  bool flush();
+  bool ok() const { return m_ok; }
+
+private:
+  static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+  int m_fd = -1;
+  std::string m_own;
+  std::string *m_buffer;
+  bool m_ok = true;
+};
+
+} // namespace hyprquery
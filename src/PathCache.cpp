@@ -0,0 +1,125 @@
+#include "PathCache.hpp"
+#include "Profiler.hpp"
+#include <cstdlib>
+#include <glob.h>
+#include <string_view>
+
+namespace hyprquery {
+
+namespace {
+
+thread_local PathCache *t_cache = nullptr;
+
+PathCache::Status statNow(const std::string &path) {
+  Profiler::count(ProfileCounter::StatCalls);
+  PathCache::Status status;
+  status.exists = stat(path.c_str(), &status.st) == 0;
+  return status;
+}
+
+std::string realpathNow(const std::string &path) {
+  Profiler::count(ProfileCounter::StatCalls);
+  char *resolved = realpath(path.c_str(), nullptr);
+  if (!resolved)
+    return {};
+  std::string result(resolved);
+  free(resolved);
+  return result;
+}
+
+// Absolute, without a trailing slash and without empty, `.` or `..`
+// components
+bool isPlain(std::string_view path) {
+  if (path.empty() || path[0] != '/')
+    return false;
+  if (path.size() == 1)
+    return true;
+  if (path.back() == '/')
+    return false;
+  for (size_t start = 1; start <= path.size();) {
+    size_t end = path.find('/', start);
+    if (end == std::string_view::npos)
+      end = path.size();
+    std::string_view part = path.substr(start, end - start);
+    if (part.empty() || part == "." || part == "..")
+      return false;
+    start = end + 1;
+  }
+  return true;
+}
+
+} // namespace
+
+PathCache::Scope::Scope() : m_cache(new PathCache), m_previous(t_cache) {
+  t_cache = m_cache;
+}
+
+PathCache::Scope::~Scope() {
+  t_cache = m_previous;
+  delete m_cache;
+}
+
+PathCache::Status PathCache::status(const std::string &path) {
+  if (!t_cache)
+    return statNow(path);
+  auto [it, inserted] = t_cache->m_status.try_emplace(path);
+  if (inserted)
+    it->second = statNow(path);
+  return it->second;
+}
+
+std::string PathCache::canonical(const std::string &path) {
+  if (!t_cache)
+    return realpathNow(path);
+  if (auto it = t_cache->m_canonical.find(path);
+      it != t_cache->m_canonical.end())
+    return it->second;
+
+  std::string result;
+  if (path == "/") {
+    result = path;
+  } else if (!isPlain(path)) {
+    result = realpathNow(path);
+  } else {
+    // An entry that is not a symlink keeps its name below its canonical
+    // parent
+    struct stat st;
+    Profiler::count(ProfileCounter::StatCalls);
+    if (lstat(path.c_str(), &st) == 0) {
+      if (S_ISLNK(st.st_mode)) {
+        result = realpathNow(path);
+      } else {
+        size_t slash = path.rfind('/');
+        std::string parent =
+            canonical(slash == 0 ? "/" : path.substr(0, slash));
+        if (!parent.empty())
+          result = (parent == "/" ? "" : parent) + path.substr(slash);
+      }
+    }
+  }
+  t_cache->m_canonical.emplace(path, result);
+  return result;
+}
+
+int PathCache::glob(const std::string &pattern, int flags,
+                    std::vector<std::string> &matches) {
+  std::string_view magic = flags & GLOB_BRACE ? "*?[\\{" : "*?[\\";
+  bool tilde = (flags & GLOB_TILDE) && pattern.starts_with('~');
+  if (!tilde && pattern.find_first_of(magic) == std::string::npos) {
+    if (!status(pattern).exists)
+      return GLOB_NOMATCH;
+    matches.push_back(pattern);
+    return 0;
+  }
+
+  glob_t result{};
+  Profiler::count(ProfileCounter::GlobCalls);
+  int ret = ::glob(pattern.c_str(), flags, nullptr, &result);
+  if (ret == 0)
+    matches.insert(matches.end(), result.gl_pathv,
+                   result.gl_pathv + result.gl_pathc);
+  globfree(&result);
+  return ret;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
+
+namespace hyprquery {
+
+// stat() and canonical path results for one phase of a run: resolving the
+// command line, scanning for keys or one parse. Every path is looked at
+// once, and canonical paths are built from the canonical parent, so the
+// files of one directory cost an lstat() each instead of a realpath().
+// Lookups use the cache of the innermost Scope on the calling thread and
+// go to the file system directly outside of one.
+class PathCache {
+public:
+  struct Status {
+    bool exists = false;
+    struct stat st {};
+
+    bool isFile() const { return exists && S_ISREG(st.st_mode); }
+  };
+
+  // Caches lookups on this thread until destroyed. Scopes are short-lived
+  // on purpose: files may change between two parses of a daemon.
+  class Scope {
+  public:
+    Scope();
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    PathCache *m_cache;
+    PathCache *m_previous;
+  };
+
+  // stat() of path, following symlinks
+  static Status status(const std::string &path);
+
+  // Absolute path with symlinks, `.` and `..` resolved; empty when path
+  // does not exist
+  static std::string canonical(const std::string &path);
+
+  // glob() that skips the directory scan for a pattern without wildcards,
+  // which matches itself when it exists. Returns glob()'s error code.
+  static int glob(const std::string &pattern, int flags,
+                  std::vector<std::string> &matches);
+
+private:
+  std::unordered_map<std::string, Status> m_status;
+  std::unordered_map<std::string, std::string> m_canonical;
+};
+
+} // namespace hyprquery
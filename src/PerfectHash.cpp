@@ -0,0 +1,67 @@
+#include "PerfectHash.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace hyprquery {
+
+bool buildPerfectHash(const std::vector<std::string_view> &keys,
+                      std::vector<int32_t> &displacements,
+                      std::vector<uint32_t> &slotToKey) {
+  constexpr uint32_t EMPTY = std::numeric_limits<uint32_t>::max();
+  constexpr int32_t MAX_SEED = 1 << 24;
+  const uint32_t size = keys.size();
+  displacements.assign(size, 0);
+  slotToKey.assign(size, EMPTY);
+  if (size == 0)
+    return true;
+
+  std::vector<std::vector<uint32_t>> buckets(size);
+  for (uint32_t i = 0; i < size; ++i)
+    buckets[perfectHash(keys[i], 0) % size].push_back(i);
+
+  std::vector<uint32_t> order(size);
+  for (uint32_t i = 0; i < size; ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return buckets[a].size() > buckets[b].size();
+  });
+
+  std::vector<uint32_t> slots;
+  size_t next = 0;
+  for (; next < order.size() && buckets[order[next]].size() > 1; ++next) {
+    const auto &bucket = buckets[order[next]];
+    int32_t seed = 1;
+    for (; seed < MAX_SEED; ++seed) {
+      slots.clear();
+      bool placed = true;
+      for (uint32_t key : bucket) {
+        uint32_t slot = perfectHash(keys[key], seed) % size;
+        if (slotToKey[slot] != EMPTY ||
+            std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          placed = false;
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (placed)
+        break;
+    }
+    if (seed == MAX_SEED)
+      return false;
+    displacements[order[next]] = seed;
+    for (size_t i = 0; i < bucket.size(); ++i)
+      slotToKey[slots[i]] = bucket[i];
+  }
+
+  // Buckets with a single key take the remaining slots directly
+  uint32_t freeSlot = 0;
+  for (; next < order.size() && !buckets[order[next]].empty(); ++next) {
+    while (slotToKey[freeSlot] != EMPTY)
+      ++freeSlot;
+    slotToKey[freeSlot] = buckets[order[next]].front();
+    displacements[order[next]] = -static_cast<int32_t>(freeSlot) - 1;
+  }
+  return true;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "BinaryIO.hpp"
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery {
+
+// Hash-and-displace minimal perfect hash over a fixed key set. Keys are
+// grouped into buckets by perfectHash(key, 0); each bucket stores either a
+// seed that spreads its keys into free slots, or (as -slot - 1) the slot of
+// its single key.
+constexpr uint32_t perfectHash(std::string_view key, uint32_t seed) {
+  uint64_t hash = fnv1a(key, 0xcbf29ce484222325ULL ^
+                                 (uint64_t(seed) * 0x9e3779b97f4a7c15ULL));
+  return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+// Slot a key maps to; callers still compare the key stored in that slot
+constexpr uint32_t perfectHashSlot(std::string_view key,
+                                   std::span<const int32_t> displacements) {
+  const uint32_t size = displacements.size();
+  const int32_t d = displacements[perfectHash(key, 0) % size];
+  return d < 0 ? static_cast<uint32_t>(-d - 1) : perfectHash(key, d) % size;
+}
+
+// Build the displacement table; slotToKey receives the index of the key
+// placed in every slot. Fails on duplicate keys.
+bool buildPerfectHash(const std::vector<std::string_view> &keys,
+                      std::vector<int32_t> &displacements,
+                      std::vector<uint32_t> &slotToKey);
+
+} // namespace hyprquery
@@ -0,0 +1,152 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <spdlog/fmt/fmt.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace hyprquery {
+
+bool Profiler::s_enabled = false;
+std::array<std::atomic<uint64_t>, static_cast<size_t>(ProfileCounter::Count)>
+    Profiler::s_counters{};
+std::mutex Profiler::s_mutex;
+std::vector<Profiler::Span> Profiler::s_spans;
+
+namespace {
+
+thread_local uint32_t t_depth = 0;
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+uint32_t threadNumber() {
+  static std::atomic<uint32_t> next{0};
+  thread_local uint32_t number = next++;
+  return number;
+}
+
+constexpr const char *COUNTER_NAMES[] = {
+    "files sourced",    "bytes copied",     "files mapped",
+    "bytes mapped",     "mappings shared",  "glob calls",
+    "stat calls",       "keys registered",  "queries executed",
+    "regex compilations",
+};
+static_assert(std::size(COUNTER_NAMES) ==
+              static_cast<size_t>(ProfileCounter::Count));
+
+double millis(int64_t ns) { return static_cast<double>(ns) / 1e6; }
+
+// Maximum resident set size of the process so far
+uint64_t peakRssKiB() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return static_cast<uint64_t>(usage.ru_maxrss);
+}
+
+} // namespace
+
+void Profiler::enable() {
+  s_enabled = true;
+  s_spans.reserve(256);
+}
+
+size_t Profiler::begin(const char *name, std::string_view detail) {
+  Span span{name, std::string(detail), nowNs(), -1, t_depth++,
+            threadNumber()};
+  std::lock_guard lock(s_mutex);
+  s_spans.push_back(std::move(span));
+  return s_spans.size() - 1;
+}
+
+void Profiler::end(size_t index) {
+  int64_t now = nowNs();
+  --t_depth;
+  std::lock_guard lock(s_mutex);
+  s_spans[index].durationNs = now - s_spans[index].startNs;
+}
+
+void Profiler::writeSummary(std::ostream &out) {
+  std::lock_guard lock(s_mutex);
+  // Totals per span name in order of first appearance, indented by depth
+  std::vector<std::string> order;
+  std::map<std::string, std::pair<int64_t, size_t>> totals;
+  std::map<std::string, uint32_t> depths;
+  std::vector<const Span *> files;
+  for (const auto &span : s_spans) {
+    if (span.durationNs < 0)
+      continue;
+    if (!totals.contains(span.name)) {
+      order.push_back(span.name);
+      depths[span.name] = span.depth;
+    }
+    auto &[total, calls] = totals[span.name];
+    total += span.durationNs;
+    ++calls;
+    if (!span.detail.empty())
+      files.push_back(&span);
+  }
+
+  out << fmt::format("{:<32} {:>10} {:>7}\n", "phase", "ms", "calls");
+  for (const auto &name : order) {
+    std::string label = std::string(depths[name] * 2, ' ') + name;
+    out << fmt::format("{:<32} {:>10.3f} {:>7}\n", label,
+                       millis(totals[name].first), totals[name].second);
+  }
+
+  if (!files.empty()) {
+    std::sort(files.begin(), files.end(), [](const Span *a, const Span *b) {
+      return a->durationNs > b->durationNs;
+    });
+    out << fmt::format("\n{:<10} {:>10}  {}\n", "span", "ms", "slowest");
+    for (size_t i = 0; i < files.size() && i < 10; ++i)
+      out << fmt::format("{:<10} {:>10.3f}  {}\n", files[i]->name,
+                         millis(files[i]->durationNs), files[i]->detail);
+  }
+
+  out << '\n';
+  for (size_t i = 0; i < s_counters.size(); ++i)
+    out << fmt::format("{:<32} {:>10}\n", COUNTER_NAMES[i],
+                       s_counters[i].load(std::memory_order_relaxed));
+  out << fmt::format("{:<32} {:>10}\n", "peak RSS (KiB)", peakRssKiB());
+}
+
+bool Profiler::writeTrace(const std::string &path) {
+  std::lock_guard lock(s_mutex);
+  int64_t origin = s_spans.empty() ? 0 : s_spans.front().startNs;
+  nlohmann::json events = nlohmann::json::array();
+  for (const auto &span : s_spans) {
+    if (span.durationNs < 0)
+      continue;
+    nlohmann::json event = {
+        {"name", span.name},
+        {"ph", "X"},
+        {"ts", static_cast<double>(span.startNs - origin) / 1e3},
+        {"dur", static_cast<double>(span.durationNs) / 1e3},
+        {"pid", getpid()},
+        {"tid", span.thread}};
+    if (!span.detail.empty())
+      event["args"] = {{"path", span.detail}};
+    events.push_back(std::move(event));
+  }
+  nlohmann::json counters;
+  for (size_t i = 0; i < s_counters.size(); ++i)
+    counters[COUNTER_NAMES[i]] = s_counters[i].load(std::memory_order_relaxed);
+  counters["peak RSS (KiB)"] = peakRssKiB();
+
+  std::ofstream out(path, std::ios::trunc);
+  out << nlohmann::json{{"traceEvents", events},
+                        {"displayTimeUnit", "ms"},
+                        {"otherData", counters}}
+             .dump();
+  return static_cast<bool>(out);
+}
+
+} // namespace hyprquery
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery {
+
+enum class ProfileCounter : uint8_t {
+  FilesSourced,
+  // Config bytes read through hyprlang's own streams
+  BytesCopied,
+  // Config files hyq reads itself, through InputFiles
+  FilesMapped,
+  BytesMapped,
+  MappingsShared,
+  GlobCalls,
+  StatCalls,
+  KeysRegistered,
+  QueriesExecuted,
+  RegexCompiled,
+  Count
+};
+
+// Wall time spans and counters for --profile. Until enable() is called
+// every hook is a single branch on a static flag.
+class Profiler {
+public:
+  static void enable();
+  static bool enabled() { return s_enabled; }
+
+  static void count(ProfileCounter counter, uint64_t amount = 1) {
+    if (s_enabled)
+      s_counters[static_cast<size_t>(counter)].fetch_add(
+          amount, std::memory_order_relaxed);
+  }
+
+  static uint64_t counter(ProfileCounter counter) {
+    return s_counters[static_cast<size_t>(counter)].load(
+        std::memory_order_relaxed);
+  }
+
+  // Phase totals, the slowest source= files, the counters and peak RSS
+  static void writeSummary(std::ostream &out);
+
+  // Chrome trace-event JSON, for chrome://tracing or Perfetto
+  static bool writeTrace(const std::string &path);
+
+private:
+  friend class ProfileSpan;
+
+  struct Span {
+    const char *name;
+    std::string detail;
+    int64_t startNs = 0;
+    int64_t durationNs = -1;
+    uint32_t depth = 0;
+    uint32_t thread = 0;
+  };
+
+  static size_t begin(const char *name, std::string_view detail);
+  static void end(size_t index);
+
+  static bool s_enabled;
+  static std::array<std::atomic<uint64_t>,
+                    static_cast<size_t>(ProfileCounter::Count)>
+      s_counters;
+  static std::mutex s_mutex;
+  static std::vector<Span> s_spans;
+};
+
+// Times the enclosing scope when profiling is enabled
+class ProfileSpan {
+public:
+  explicit ProfileSpan(const char *name, std::string_view detail = {}) {
+    if (Profiler::enabled())
+      m_index = Profiler::begin(name, detail);
+  }
+  ~ProfileSpan() { finish(); }
+
+  // End the span before the scope does
+  void finish() {
+    if (m_index != NONE)
+      Profiler::end(m_index);
+    m_index = NONE;
+  }
+
+  ProfileSpan(const ProfileSpan &) = delete;
+  ProfileSpan &operator=(const ProfileSpan &) = delete;
+
+private:
+  static constexpr size_t NONE = static_cast<size_t>(-1);
+  size_t m_index = NONE;
+};
+
+} // namespace hyprquery
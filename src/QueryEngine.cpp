@@ -0,0 +1,566 @@
+#include "QueryEngine.hpp"
+#include "Color.hpp"
+#include "ConfigScanner.hpp"
+#include "InputFiles.hpp"
+#include "KeyIndex.hpp"
+#include "PathCache.hpp"
+#include "Profiler.hpp"
+#include "QueryFilter.hpp"
+#include "Schema.hpp"
+#include "SourceHandler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+#include <tuple>
+
+namespace hyprquery {
+
+QueryEngine::QueryEngine(EngineOptions options)
+    : m_options(std::move(options)), m_keywordSet(m_options.keywords) {}
+
+QueryEngine::~QueryEngine() = default;
+
+namespace {
+
+// Reserved scratch value that $VARIABLE queries are evaluated into
+constexpr const char *VARIABLE_KEY = "hyprquery:variable";
+
+// What EngineOptions::dumpAll expands
+constexpr const char *DUMP_KEYS = "*";
+constexpr const char *DUMP_VARIABLES = "$*";
+
+} // namespace
+
+std::any QueryEngine::lookup(const QueryInput &query) const {
+  if (!query.isDynamicVariable)
+    return m_config->getConfigValue(query.query.c_str());
+  // hyprlang expands the value against the variable table of the parse,
+  // including variables from sourced files
+  std::lock_guard lock(m_variableMutex);
+  if (m_config->parseDynamic(VARIABLE_KEY, query.query.c_str()).error)
+    return {};
+  return m_config->getConfigValue(VARIABLE_KEY);
+}
+
+bool QueryEngine::isKeyword(const QueryInput &query) const {
+  return !query.isDynamicVariable && !query.isPattern &&
+         m_keywordSet.match(query.query) >= 0;
+}
+
+const Schema *QueryEngine::schema() {
+  // Loaded once per engine, rebuilds for new keys reuse it
+  if (!m_schemaLoaded) {
+    m_schemaLoaded = true;
+    ProfileSpan span("schema load");
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    if (m_options.builtinSchema)
+      m_schema = Schema::builtin();
+    else if (!m_options.schemaPath.empty())
+      m_schema = Schema::load(m_options.schemaPath, error);
+    if (!error.empty())
+      spdlog::error("{}", error);
+    else if (m_schema)
+      spdlog::debug("[schema] Loaded {} options in {}us", m_schema->size(),
+                    std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count());
+  }
+  return m_schema.get();
+}
+
+void QueryEngine::prepareConfig(const std::vector<QueryInput> &queries,
+                                const std::vector<std::string> &extraKeys) {
+  const bool debugLogging = m_options.debugLogging;
+  InputFiles::Scope inputs;
+  m_registeredKeys.clear();
+  m_known.clear();
+  m_variables.clear();
+  m_expansions.clear();
+
+  Hyprlang::SConfigOptions options;
+  options = {.verifyOnly = m_options.getDefaults,
+             .throwAllErrors = m_options.validate,
+             .allowMissingConfig = true};
+
+  for (const auto &q : queries) {
+    if (q.isDynamicVariable && !q.isPattern)
+      m_variables.push_back(q.query);
+  }
+  for (const auto &key : extraKeys) {
+    if (!key.empty() && key[0] == '$' && !isKeyPattern(key))
+      m_variables.push_back(key);
+  }
+
+  m_config = std::make_unique<Hyprlang::CConfig>(m_options.configPath.c_str(),
+                                                 options);
+
+  // Plain keys to register, with wildcard queries expanded against the
+  // schema and the keys the config assigns. Variable patterns expand
+  // against the variables the config defines.
+  std::vector<std::string> needed;
+  std::vector<std::string> patterns;
+  for (const auto &q : queries) {
+    if (q.isPattern)
+      patterns.push_back(q.query);
+    else if (!q.isDynamicVariable)
+      needed.push_back(q.query);
+  }
+  for (const auto &key : extraKeys) {
+    if (isKeyPattern(key))
+      patterns.push_back(key);
+    else if (!key.empty() && key[0] != '$')
+      needed.push_back(key);
+  }
+  if (m_options.dumpAll) {
+    patterns.push_back(DUMP_KEYS);
+    patterns.push_back(DUMP_VARIABLES);
+  } else if (m_options.validate) {
+    // Keys outside the schema become placeholders instead of parse errors
+    patterns.push_back(DUMP_KEYS);
+  }
+  if (!patterns.empty()) {
+    ProfileSpan span("expand patterns");
+    KeyIndex index;
+    KeyIndex variableIndex;
+    if (const Schema *loaded = schema()) {
+      for (const auto &option : loaded->options())
+        index.add(option.key);
+    }
+    std::vector<std::string> variables;
+    for (const auto &key : ConfigScanner::collectKeys(
+             m_options.configPath, m_options.followSource, &variables))
+      index.add(key);
+    for (const auto &variable : variables)
+      variableIndex.add(variable);
+    index.finalize();
+    variableIndex.finalize();
+    for (const auto &pattern : patterns) {
+      const bool isVariable = pattern[0] == '$';
+      const KeyIndex &source = isVariable ? variableIndex : index;
+      auto &matches = m_expansions[pattern];
+      matches = source.match(pattern);
+      auto &target = isVariable ? m_variables : needed;
+      target.insert(target.end(), matches.begin(), matches.end());
+      if (debugLogging)
+        spdlog::debug("[pattern] '{}' matches {} of {} keys", pattern,
+                      matches.size(), source.size());
+    }
+  }
+  std::sort(m_variables.begin(), m_variables.end());
+  m_variables.erase(std::unique(m_variables.begin(), m_variables.end()),
+                    m_variables.end());
+  std::sort(needed.begin(), needed.end());
+  needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+  // Values have to be registered before commence(); schema keys go first so
+  // their typed defaults win over the STRING placeholders for queried keys
+  const Schema *loaded = schema();
+  ProfileSpan span("register");
+  if (loaded) {
+    if (m_options.lazySchema) {
+      m_registeredKeys =
+          ConfigUtils::addConfigValuesFromSchema(*m_config, *loaded, needed);
+    } else {
+      m_registeredKeys =
+          ConfigUtils::addConfigValuesFromSchema(*m_config, *loaded);
+    }
+  }
+  m_known.insert(m_registeredKeys.begin(), m_registeredKeys.end());
+  auto registerPlaceholder = [&](const std::string &key) {
+    // A keyword goes to its handler, a value of the same name would
+    // take its lines
+    if (key.empty() || key[0] == '$' || m_keywordSet.match(key) >= 0 ||
+        !m_known.insert(key).second)
+      return;
+    m_config->addConfigValue(key.c_str(), (Hyprlang::STRING) "");
+    m_registeredKeys.push_back(key);
+  };
+
+  m_config->addConfigValue(VARIABLE_KEY, (Hyprlang::STRING) "");
+  for (const auto &key : needed)
+    registerPlaceholder(key);
+  // Without -s a source= line is not an error worth reporting
+  if (m_options.validate && !m_options.followSource)
+    registerPlaceholder("source");
+  m_keywordSet.registerHandlers(*m_config);
+  m_config->commence();
+  Profiler::count(ProfileCounter::KeysRegistered, m_registeredKeys.size());
+}
+
+void QueryEngine::parse() {
+  m_dependencies.clear();
+  m_parseError.clear();
+  // The prefetcher and the source graph read every file, hyprlang reads
+  // it once more through its own streams
+  InputFiles::Scope inputs;
+
+  SourceContext context;
+  context.config = m_config.get();
+  context.configDir =
+      std::filesystem::path(m_options.configPath).parent_path().string();
+  if (m_options.trackDependencies) {
+    m_dependencies.push_back(FileStamp::capture(m_options.configPath));
+    if (!m_options.schemaPath.empty())
+      m_dependencies.push_back(FileStamp::capture(m_options.schemaPath));
+    context.trackDependencies = true;
+  }
+  if (m_options.incremental) {
+    m_sourceGraph.clear();
+    m_sourceGraph.enter(m_options.configPath);
+    context.sourceGraph = &m_sourceGraph;
+  }
+  m_keywords.reset();
+  if (!m_keywordSet.empty()) {
+    m_keywords = std::make_shared<KeywordStore>(m_keywordSet);
+    m_keywords->enter(m_options.configPath);
+    context.keywords = m_keywords.get();
+  }
+  std::optional<IoPrefetcher> prefetcher;
+  if (m_options.followSource) {
+    if (m_options.debugLogging)
+      spdlog::debug("Registering source handler");
+    SourceHandler::registerHandler(m_config.get());
+    // Workers walk the source graph from the main config while it is
+    // being parsed, so sourced files are usually cached when reached
+    if (m_options.prefetchWorkers > 0) {
+      prefetcher.emplace(m_options.prefetchWorkers);
+      prefetcher->prefetch(m_options.configPath, true);
+      context.prefetcher = &*prefetcher;
+    }
+  }
+
+  if (Profiler::enabled()) {
+    std::error_code ec;
+    Profiler::count(ProfileCounter::BytesCopied,
+                    std::filesystem::file_size(m_options.configPath, ec));
+  }
+  SourceHandler::Scope scope(context);
+  PathCache::Scope paths;
+  ProfileSpan span("hyprlang parse");
+  const auto PARSERESULT = m_config->parse();
+  span.finish();
+  if (PARSERESULT.error)
+    m_parseError = PARSERESULT.getError();
+  if (m_keywords)
+    m_keywords->leave();
+  if (m_options.incremental) {
+    m_sourceGraph.leave(!PARSERESULT.error);
+    m_sourceGraph.verify();
+  }
+
+  if (m_options.trackDependencies) {
+    m_dependencies.insert(m_dependencies.end(), context.dependencies.begin(),
+                          context.dependencies.end());
+    m_dependenciesComplete = context.dependenciesComplete;
+  }
+}
+
+bool QueryEngine::reparseChanged() {
+  if (!m_options.incremental)
+    return false;
+  // Files outside the graph are glob directories, missing source= targets
+  // and the schema; any change to them can change the graph itself
+  for (const auto &dep : m_dependencies) {
+    if (!m_sourceGraph.contains(dep.path) &&
+        !FileStamp::capture(dep.path).matches(dep))
+      return false;
+  }
+  InputFiles::Scope inputs;
+  auto changed = m_sourceGraph.update();
+  if (!changed)
+    return false;
+  // Keyword entries only ever append, so a file with keyword lines would
+  // capture them twice
+  for (const auto &path : *changed) {
+    if (m_keywords && m_keywords->touches(path))
+      return false;
+  }
+
+  SourceContext context;
+  context.config = m_config.get();
+  SourceHandler::Scope scope(context);
+  PathCache::Scope paths;
+  for (const auto &path : *changed) {
+    spdlog::debug("[graph] Reparsing {} in place", path);
+    context.configDir = std::filesystem::path(path).parent_path().string();
+    auto result = m_config->parseFile(path.c_str());
+    // An error or a write racing the parse leaves state a cold parse
+    // would not produce
+    if (result.error || !m_sourceGraph.isCurrent(path))
+      return false;
+  }
+  for (auto &dep : m_dependencies) {
+    if (std::find(changed->begin(), changed->end(), dep.path) !=
+        changed->end())
+      dep = FileStamp::capture(dep.path);
+  }
+  return true;
+}
+
+bool QueryEngine::covers(const std::vector<QueryInput> &queries) const {
+  for (const auto &q : queries) {
+    if (q.isPattern) {
+      if (!m_expansions.contains(q.query))
+        return false;
+    } else if (!q.isDynamicVariable && !m_known.contains(q.query) &&
+               !isKeyword(q)) {
+      // Variables are looked up after the parse, they never need a rebuild
+      return false;
+    }
+  }
+  return true;
+}
+
+// Decode a color or gradient into the query's format; NULL when the value is
+// neither. An INT is taken as a packed 0xAARRGGBB color.
+void applyColorFormat(QueryResult &result, ColorFormat format) {
+  std::optional<Gradient> gradient;
+  if (auto *text = std::get_if<std::string>(&result.value)) {
+    gradient = parseGradient(*text);
+  } else if (auto *integer = std::get_if<int64_t>(&result.value);
+             integer && *integer >= 0 && *integer <= UINT32_MAX) {
+    gradient.emplace();
+    gradient->stops[gradient->count++] = static_cast<uint32_t>(*integer);
+  }
+  if (!gradient || (format == ColorFormat::Int && !gradient->isColor())) {
+    result.value = {};
+    result.type = "NULL";
+    return;
+  }
+  result.type = gradient->isColor() ? "COLOR" : "GRADIENT";
+  if (format == ColorFormat::Int) {
+    result.value = int64_t(gradient->stops[0]);
+  } else if (format == ColorFormat::Json) {
+    result.value = *gradient;
+  } else {
+    // Stops separated by spaces, then the angle, like the config wrote them
+    std::string text;
+    for (size_t i = 0; i < gradient->count; ++i) {
+      char color[16];
+      char *end = formatColor(color, gradient->stops[i], format);
+      if (i > 0)
+        text += ' ';
+      text.append(color, end);
+    }
+    if (gradient->hasAngle) {
+      text += ' ';
+      text += ValueText(gradient->angle).view();
+      text += "deg";
+    }
+    result.value = std::move(text);
+  }
+}
+
+void applyQueryFilters(QueryResult &result, const QueryInput &query) {
+  // Filters pick entries out of a list, and a list they empty is NULL
+  if (auto *list = std::get_if<KeywordList>(&result.value)) {
+    if (query.filter) {
+      std::erase_if(list->entries, [&](uint32_t entry) {
+        return !query.filter->accepts(result.type,
+                                      list->store->value(entry));
+      });
+    }
+    if (list->entries.empty()) {
+      result.value = {};
+      result.type = "NULL";
+    }
+    return;
+  }
+  // An undefined variable comes back as its own name
+  auto *text = std::get_if<std::string>(&result.value);
+  if (query.isDynamicVariable && text && *text == query.query) {
+    result.value = {};
+    result.type = "NULL";
+  }
+  if (query.filter &&
+      !query.filter->accepts(result.type, ValueText(result.value))) {
+    result.value = {};
+    result.type = "NULL";
+  }
+  if (query.colorFormat != ColorFormat::None && result.type != "NULL")
+    applyColorFormat(result, query.colorFormat);
+}
+
+std::vector<QueryResult>
+QueryEngine::executeQueries(const std::vector<QueryInput> &queries) const {
+  const bool debugLogging = m_options.debugLogging;
+  std::vector<QueryResult> results;
+  auto execute = [&](const QueryInput &query) {
+    QueryResult result;
+    result.key = query.query;
+    if (isKeyword(query)) {
+      result.type = "LIST";
+      if (m_keywords)
+        result.value = KeywordList{m_keywords, m_keywords->select(query.query)};
+      applyQueryFilters(result, query);
+      results.push_back(result);
+      Profiler::count(ProfileCounter::QueriesExecuted);
+      return;
+    }
+    std::any value = lookup(query);
+    if (debugLogging && query.isDynamicVariable)
+      spdlog::debug("[variable-search] Resolved '{}' from the variable table",
+                    query.query);
+    result.value = ConfigUtils::convertValue(value);
+    result.type = ConfigUtils::getValueTypeName(value);
+    applyQueryFilters(result, query);
+    results.push_back(result);
+    Profiler::count(ProfileCounter::QueriesExecuted);
+  };
+  // A query asked again with the same filter and format copies the first
+  // answer; equal filters share one compiled instance
+  std::unordered_map<std::string_view, size_t> seen;
+  std::vector<std::pair<size_t, size_t>> answers(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    const QueryInput &query = queries[i];
+    size_t begin = results.size();
+    if (queries.size() > 1) {
+      auto [it, inserted] = seen.try_emplace(query.query, i);
+      if (!inserted && queries[it->second].filter == query.filter &&
+          queries[it->second].colorFormat == query.colorFormat) {
+        auto [from, to] = answers[it->second];
+        for (size_t k = from; k < to; ++k)
+          results.push_back(results[k]);
+        answers[i] = {begin, results.size()};
+        continue;
+      }
+    }
+    if (!query.isPattern) {
+      execute(query);
+      answers[i] = {begin, results.size()};
+      continue;
+    }
+    // Every match is answered like a plain query with the same filters; a
+    // pattern without matches yields a single NULL result
+    auto it = m_expansions.find(query.query);
+    if (it == m_expansions.end() || it->second.empty()) {
+      results.push_back({query.query, {}, "NULL", {}, {}});
+    } else {
+      QueryInput expanded = query;
+      expanded.isPattern = false;
+      for (const auto &key : it->second) {
+        expanded.query = key;
+        execute(expanded);
+      }
+    }
+    answers[i] = {begin, results.size()};
+  }
+  return results;
+}
+
+std::vector<QueryResult> QueryEngine::dump(bool includeDefaults) const {
+  std::vector<QueryInput> queries;
+  for (const char *pattern : {DUMP_KEYS, DUMP_VARIABLES}) {
+    auto it = m_expansions.find(pattern);
+    if (it == m_expansions.end())
+      continue;
+    queries.reserve(queries.size() + it->second.size());
+    for (const auto &key : it->second) {
+      QueryInput query{};
+      query.isDynamicVariable = key[0] == '$';
+      if (!includeDefaults && !query.isDynamicVariable &&
+          m_keywordSet.match(key) < 0) {
+        auto *value = m_config->getConfigValuePtr(key.c_str());
+        if (!value || !value->m_bSetByUser)
+          continue;
+      }
+      query.query = key;
+      queries.push_back(std::move(query));
+    }
+  }
+  return executeQueries(queries);
+}
+
+std::vector<Violation> QueryEngine::validate() const {
+  InputFiles::Scope inputs;
+  std::vector<Violation> violations =
+      parseErrorViolations(m_parseError, m_options.configPath);
+  if (m_schema) {
+    std::vector<std::string> keys;
+    size_t parseErrors = violations.size();
+    for (const auto &result : dump(false)) {
+      auto option = m_schema->find(result.key);
+      if (!option)
+        continue;
+      if (auto violation = checkValue(*m_schema, *option, result)) {
+        keys.push_back(result.key);
+        violations.push_back(std::move(*violation));
+      }
+    }
+    // Only keys with a violation are looked up again
+    auto locations = ConfigScanner::locateKeys(
+        m_options.configPath, m_options.followSource, keys);
+    for (size_t i = parseErrors; i < violations.size(); ++i) {
+      auto it = locations.find(violations[i].key);
+      if (it != locations.end()) {
+        violations[i].file =
+            std::filesystem::path(it->second.file).lexically_normal();
+        violations[i].line = it->second.line;
+      } else {
+        violations[i].file = m_options.configPath;
+      }
+    }
+  }
+  std::stable_sort(violations.begin(), violations.end(),
+                   [](const Violation &a, const Violation &b) {
+                     return std::tie(a.file, a.line) <
+                            std::tie(b.file, b.line);
+                   });
+  return violations;
+}
+
+SnapshotData QueryEngine::snapshot() const {
+  SnapshotData data;
+  data.dependencies = m_dependencies;
+  data.parseError = m_parseError;
+
+  data.envNames.push_back("HOME");
+  InputFiles::Scope inputs;
+  for (const auto &dep : data.dependencies) {
+    if (dep.kind != FileStamp::Kind::File || dep.path == m_options.schemaPath)
+      continue;
+    auto file = InputFiles::map(dep.path);
+    ConfigCache::collectEnvReferences(file->view(), data.envNames);
+  }
+
+  auto addEntry = [&](const std::string &key) {
+    QueryInput query;
+    query.query = key;
+    query.isDynamicVariable = key[0] == '$';
+    std::any value = lookup(query);
+    data.entries.push_back({key, ConfigUtils::getValueTypeName(value),
+                            ConfigUtils::convertValue(value)});
+  };
+  for (const auto &key : m_registeredKeys)
+    addEntry(key);
+  for (const auto &variable : m_variables) {
+    ConfigCache::collectEnvReferences(variable, data.envNames);
+    addEntry(variable);
+  }
+  return data;
+}
+
+std::optional<std::vector<QueryResult>>
+executeCachedQueries(const std::vector<QueryInput> &queries,
+                     const ConfigCache &cache) {
+  std::vector<QueryResult> results;
+  for (const auto &query : queries) {
+    // Snapshots hold no key index, so patterns always take the parse path
+    if (query.isPattern)
+      return std::nullopt;
+    auto cached = cache.lookup(query.query);
+    if (!cached)
+      return std::nullopt;
+    QueryResult result;
+    result.key = query.query;
+    result.value = cached->value;
+    result.type = cached->type;
+    applyQueryFilters(result, query);
+    results.push_back(result);
+  }
+  return results;
+}
+
+} // namespace hyprquery
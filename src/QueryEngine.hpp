@@ -0,0 +1,129 @@
+#pragma once
+
+#include "ConfigCache.hpp"
+#include "ConfigUtils.hpp"
+#include "KeywordStore.hpp"
+#include "SourceGraph.hpp"
+#include "Validator.hpp"
+#include <hyprlang.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace hyprquery {
+
+class Schema;
+
+struct EngineOptions {
+  std::string configPath;
+  std::string schemaPath;
+  bool builtinSchema = false;
+  // Register only the schema options the queries need
+  bool lazySchema = false;
+  // Threads reading sourced files ahead of the parser, 0 disables
+  size_t prefetchWorkers = 4;
+  bool followSource = false;
+  bool getDefaults = false;
+  bool trackDependencies = false;
+  // Record the source graph so reparseChanged() can update in place
+  bool incremental = false;
+  // Register every schema key, every assigned key and every variable so
+  // dump() can list them
+  bool dumpAll = false;
+  // Register every assigned key and keep every parse error for validate()
+  bool validate = false;
+  // Answer plain queries from the raw text when FastPath can prove the
+  // result matches a parse
+  bool fastPath = true;
+  // Repeated keywords captured with handlers into a KeywordStore; querying
+  // one gives every value it was given as a LIST
+  std::vector<std::string> keywords = defaultKeywords();
+  bool debugLogging = false;
+};
+
+// Owns one parsed config and answers queries against it
+class QueryEngine {
+public:
+  explicit QueryEngine(EngineOptions options);
+  ~QueryEngine();
+
+  QueryEngine(const QueryEngine &) = delete;
+  QueryEngine &operator=(const QueryEngine &) = delete;
+
+  // Register the schema, every queried key and extraKeys, then commence
+  void prepareConfig(const std::vector<QueryInput> &queries,
+                     const std::vector<std::string> &extraKeys = {});
+
+  // Parse the config, following source= when enabled
+  void parse();
+
+  // Parse the files that changed since the last parse again on top of the
+  // current values. False when only a full parse gives the same result as
+  // a cold one; the engine must then be rebuilt.
+  bool reparseChanged();
+
+  // True when every query can be answered without registering new keys
+  bool covers(const std::vector<QueryInput> &queries) const;
+
+  std::vector<QueryResult>
+  executeQueries(const std::vector<QueryInput> &queries) const;
+
+  // Every key, then every variable, with EngineOptions::dumpAll. Schema
+  // defaults the config never sets are left out unless includeDefaults.
+  std::vector<QueryResult> dump(bool includeDefaults) const;
+
+  // Every parse error and every assigned value the schema rejects, with
+  // EngineOptions::validate; ordered by file and line
+  std::vector<Violation> validate() const;
+
+  // Resolved values and source graph of the last parse
+  SnapshotData snapshot() const;
+
+  const std::vector<FileStamp> &dependencies() const { return m_dependencies; }
+  bool dependenciesComplete() const { return m_dependenciesComplete; }
+  const std::vector<std::string> &registeredKeys() const {
+    return m_registeredKeys;
+  }
+  const std::vector<std::string> &variableQueries() const {
+    return m_variables;
+  }
+  const std::string &parseError() const { return m_parseError; }
+  const EngineOptions &options() const { return m_options; }
+
+private:
+  std::any lookup(const QueryInput &query) const;
+  bool isKeyword(const QueryInput &query) const;
+  const Schema *schema();
+
+  EngineOptions m_options;
+  KeywordSet m_keywordSet;
+  // Entries of the last parse; results keep the store alive
+  std::shared_ptr<KeywordStore> m_keywords;
+  std::unique_ptr<Schema> m_schema;
+  bool m_schemaLoaded = false;
+  std::unique_ptr<Hyprlang::CConfig> m_config;
+  std::vector<std::string> m_registeredKeys;
+  std::unordered_set<std::string> m_known;
+  // Variables queried at prepare time, recorded in snapshots
+  std::vector<std::string> m_variables;
+  mutable std::mutex m_variableMutex;
+  // Wildcard query -> matching keys, in sorted order
+  std::unordered_map<std::string, std::vector<std::string>> m_expansions;
+  std::vector<FileStamp> m_dependencies;
+  bool m_dependenciesComplete = true;
+  SourceGraph m_sourceGraph;
+  std::string m_parseError;
+};
+
+void applyQueryFilters(QueryResult &result, const QueryInput &query);
+
+// Answer every query from a snapshot, or nothing if one of them is missing
+std::optional<std::vector<QueryResult>>
+executeCachedQueries(const std::vector<QueryInput> &queries,
+                     const ConfigCache &cache);
+
+} // namespace hyprquery
@@ -0,0 +1,67 @@
+#include "QueryFilter.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace hyprquery {
+
+namespace {
+
+// A daemon sees whatever its clients send, so the cache starts over once
+// it holds this many filters
+constexpr size_t MAX_CACHED = 4096;
+
+char upper(char c) {
+  return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+}
+
+} // namespace
+
+QueryFilter::QueryFilter(std::string_view type, std::string_view regex)
+    : m_type(type == "*" ? "" : type) {
+  std::transform(m_type.begin(), m_type.end(), m_type.begin(), upper);
+  if (regex.empty())
+    return;
+  Profiler::count(ProfileCounter::RegexCompiled);
+  try {
+    m_regex = std::make_unique<Regex>(regex);
+  } catch (const std::invalid_argument &e) {
+    throw std::invalid_argument("Invalid regex '" + std::string(regex) +
+                                "': " + e.what());
+  }
+}
+
+std::shared_ptr<const QueryFilter> QueryFilter::get(std::string_view type,
+                                                    std::string_view regex) {
+  if (type.empty() && regex.empty())
+    return nullptr;
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::shared_ptr<const QueryFilter>>
+      cache;
+  // Types compare case-insensitively, so [int] and [INT] share a filter
+  std::string key(type);
+  std::transform(key.begin(), key.end(), key.begin(), upper);
+  key.push_back('\0');
+  key.append(regex);
+
+  std::lock_guard lock(mutex);
+  if (auto it = cache.find(key); it != cache.end())
+    return it->second;
+  auto filter = std::make_shared<const QueryFilter>(type, regex);
+  if (cache.size() >= MAX_CACHED)
+    cache.clear();
+  cache.emplace(std::move(key), filter);
+  return filter;
+}
+
+bool QueryFilter::accepts(std::string_view type, std::string_view value) const {
+  if (!m_type.empty() &&
+      !std::ranges::equal(m_type, type, {}, {}, upper))
+    return false;
+  return !m_regex || m_regex->fullMatch(value);
+}
+
+} // namespace hyprquery
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Regex.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace hyprquery {
+
+// The [type][regex] part of a query; a type of * accepts any type. Each
+// distinct pair is compiled once per process and shared by every query,
+// batch line and daemon request that uses it.
+class QueryFilter {
+public:
+  QueryFilter(std::string_view type, std::string_view regex);
+
+  // The shared filter for type and regex, null when both are empty.
+  // Throws std::invalid_argument for an invalid regex.
+  static std::shared_ptr<const QueryFilter> get(std::string_view type,
+                                                std::string_view regex);
+
+  // True when a result of this type and value passes
+  bool accepts(std::string_view type, std::string_view value) const;
+
+  const Regex *regex() const { return m_regex.get(); }
+
+private:
+  // Upper-cased, empty for any type
+  std::string m_type;
+  std::unique_ptr<Regex> m_regex;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,158 @@
+#include "QueryRunner.hpp"
+#include "BinaryIO.hpp"
+#include "BuiltinSchema.hpp"
+#include "ConfigCache.hpp"
+#include "FastPath.hpp"
+#include "InputFiles.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+namespace hyprquery {
+
+ConfigOutcome runJob(const ConfigJob &job, bool useCache) {
+  const EngineOptions &options = job.options;
+  ConfigOutcome outcome;
+  // Every reader of a config file during the job shares one mapping of it
+  InputFiles::Scope inputs;
+  // Cheaper than checking a snapshot, which it never needs
+  if (auto fast = FastPath::run(options, job.queries)) {
+    outcome.results = std::move(fast->results);
+    outcome.parseError = std::move(fast->parseError);
+    return outcome;
+  }
+  std::unique_ptr<ConfigCache> cache;
+  // Snapshots hold no key index to dump and no schema to validate against
+  if (useCache && !options.dumpAll && !options.validate) {
+    ProfileSpan span("cache lookup");
+    // Keywords and the queried keys decide which lines are unknown-key
+    // errors, so a snapshot only answers the query set it was parsed for
+    // and reports the parse error a cold run of it would
+    std::string keywords;
+    for (const auto &keyword : options.keywords)
+      keywords += keyword + ",";
+    std::vector<std::string> queried;
+    for (const auto &query : job.queries)
+      queried.push_back(query.query);
+    std::sort(queried.begin(), queried.end());
+    queried.erase(std::unique(queried.begin(), queried.end()), queried.end());
+    std::string keys;
+    for (const auto &key : queried)
+      keys += key + '\n';
+    uint64_t fingerprint = fnv1a(
+        std::string("source=") + (options.followSource ? "1" : "0") +
+        ";defaults=" + (options.getDefaults ? "1" : "0") +
+        ";lazy=" + (options.lazySchema ? "1" : "0") + ";builtin=" +
+        (options.builtinSchema ? std::to_string(builtin_schema::SOURCE_HASH)
+                               : "0") +
+        ";keywords=" + keywords + ";keys=" + keys);
+    cache = std::make_unique<ConfigCache>(
+        ConfigCache::defaultSnapshotPath(options.configPath,
+                                         options.schemaPath, fingerprint),
+        fingerprint);
+    bool opened = cache->open();
+    if (opened && cache->isFresh()) {
+      auto results = executeCachedQueries(job.queries, *cache);
+      if (results) {
+        spdlog::debug("[cache] Hit: {}", cache->path());
+        outcome.results = std::move(*results);
+        outcome.parseError = cache->parseError();
+        return outcome;
+      }
+      spdlog::debug("[cache] Miss: query not in snapshot {}", cache->path());
+    } else {
+      spdlog::debug("[cache] Miss: {} ({})", cache->staleReason(),
+                    cache->path());
+    }
+  }
+
+  EngineOptions engineOptions = options;
+  engineOptions.trackDependencies = cache != nullptr;
+  QueryEngine engine(engineOptions);
+  {
+    ProfileSpan span("prepare");
+    engine.prepareConfig(job.queries);
+  }
+  {
+    ProfileSpan span("parse");
+    engine.parse();
+  }
+  outcome.parseError = engine.parseError();
+  {
+    ProfileSpan span("query");
+    outcome.results = engine.executeQueries(job.queries);
+    if (options.dumpAll) {
+      auto dumped = engine.dump(job.includeDefaults);
+      outcome.results.insert(outcome.results.end(),
+                             std::make_move_iterator(dumped.begin()),
+                             std::make_move_iterator(dumped.end()));
+    }
+  }
+  if (options.validate) {
+    ProfileSpan span("validate");
+    outcome.violations = engine.validate();
+  }
+
+  if (cache) {
+    ProfileSpan span("store snapshot");
+    auto snapshot = engine.snapshot();
+    // A file that changed while it was being parsed must not be recorded
+    // with its new stamp and its old values
+    bool unchanged = engine.dependenciesComplete();
+    for (const auto &dep : snapshot.dependencies) {
+      if (unchanged && !FileStamp::capture(dep.path).matches(dep))
+        unchanged = false;
+    }
+    if (!unchanged)
+      spdlog::debug("[cache] Not storing snapshot: source graph is not "
+                    "stable");
+    else if (cache->store(snapshot))
+      spdlog::debug("[cache] Stored snapshot with {} values: {}",
+                    snapshot.entries.size(), cache->path());
+  }
+  return outcome;
+}
+
+std::vector<ConfigOutcome> runJobs(const std::vector<ConfigJob> &jobs,
+                                   bool useCache) {
+  std::vector<ConfigOutcome> outcomes(jobs.size());
+  std::vector<std::exception_ptr> errors(jobs.size());
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i; (i = next++) < jobs.size();) {
+      try {
+        outcomes[i] = runJob(jobs[i], useCache);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+  // Every parse has its own hyprlang instance and source= state, so the
+  // calling thread plus one worker per further job, up to the core count
+  size_t threads = std::min<size_t>(
+      jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < threads; ++i)
+    pool.emplace_back(worker);
+  worker();
+  for (auto &thread : pool)
+    thread.join();
+  for (const auto &error : errors) {
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  if (jobs.size() > 1) {
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      for (auto &result : outcomes[i].results)
+        result.file = jobs[i].label;
+    }
+  }
+  return outcomes;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,32 @@
+#pragma once
+#include "QueryEngine.hpp"
+
+namespace hyprquery {
+
+// One config file of an invocation with the queries asked of it
+struct ConfigJob {
+  // The config as given on the command line, tags its results
+  std::string label;
+  EngineOptions options;
+  std::vector<QueryInput> queries;
+  // With EngineOptions::dumpAll, list schema defaults the config never sets
+  bool includeDefaults = true;
+};
+
+struct ConfigOutcome {
+  std::vector<QueryResult> results;
+  std::string parseError;
+  // With EngineOptions::validate
+  std::vector<Violation> violations;
+};
+
+// Answer a job from its snapshot when useCache allows, otherwise parse the
+// config and, with useCache, store a new snapshot
+ConfigOutcome runJob(const ConfigJob &job, bool useCache);
+
+// Run every job, several at once on a thread pool. Outcomes are in job
+// order; with more than one job every result carries its job's label.
+std::vector<ConfigOutcome> runJobs(const std::vector<ConfigJob> &jobs,
+                                   bool useCache);
+
+} // namespace hyprquery
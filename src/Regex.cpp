@@ -0,0 +1,627 @@
+#include "Regex.hpp"
+#include <cctype>
+#include <regex>
+#include <stdexcept>
+
+namespace hyprquery {
+
+struct Regex::Fallback {
+  std::regex regex;
+};
+
+namespace {
+
+using Set = std::bitset<256>;
+using Op = Regex::Instruction::Op;
+
+enum Assertion : uint8_t { Begin, End, WordBoundary, NotWordBoundary };
+
+// Above this many instructions counted repeats go to std::regex
+constexpr size_t MAX_PROGRAM = 20000;
+constexpr int MAX_REPEAT = 1000;
+
+// Thrown for constructs only std::regex handles
+struct NotRegular {};
+
+struct Node {
+  enum class Kind : uint8_t { Empty, Set, Assert, Concat, Alternate, Repeat };
+  Kind kind = Kind::Empty;
+  Set set;
+  Assertion assertion = Begin;
+  int min = 0;
+  int max = -1;
+  std::vector<Node> children;
+};
+
+Set rangeSet(unsigned char from, unsigned char to) {
+  Set set;
+  for (unsigned c = from; c <= to; ++c)
+    set.set(c);
+  return set;
+}
+
+Set charSet(unsigned char c) {
+  Set set;
+  set.set(c);
+  return set;
+}
+
+Set digitSet() { return rangeSet('0', '9'); }
+
+Set wordSet() {
+  return rangeSet('a', 'z') | rangeSet('A', 'Z') | digitSet() | charSet('_');
+}
+
+Set spaceSet() { return rangeSet('\t', '\r') | charSet(' '); }
+
+Set anySet() { return ~(charSet('\n') | charSet('\r')); }
+
+bool isWord(unsigned char c) { return std::isalnum(c) || c == '_'; }
+
+class Parser {
+public:
+  explicit Parser(std::string_view pattern) : m_pattern(pattern) {}
+
+  Node parse() {
+    Node node = alternation();
+    if (m_pos < m_pattern.size())
+      fail("unmatched ')'");
+    return node;
+  }
+
+private:
+  [[noreturn]] void fail(const std::string &reason) const {
+    throw std::invalid_argument(reason + " at offset " +
+                                std::to_string(m_pos));
+  }
+
+  bool atEnd() const { return m_pos >= m_pattern.size(); }
+  char peek() const { return m_pattern[m_pos]; }
+
+  Node alternation() {
+    Node first = sequence();
+    if (atEnd() || peek() != '|')
+      return first;
+    Node node;
+    node.kind = Node::Kind::Alternate;
+    node.children.push_back(std::move(first));
+    while (!atEnd() && peek() == '|') {
+      ++m_pos;
+      node.children.push_back(sequence());
+    }
+    return node;
+  }
+
+  Node sequence() {
+    Node node;
+    node.kind = Node::Kind::Concat;
+    while (!atEnd() && peek() != '|' && peek() != ')')
+      node.children.push_back(term());
+    return node;
+  }
+
+  Node term() {
+    Node atom = this->atom();
+    if (atEnd() || !isQuantifier(peek()))
+      return atom;
+    if (atom.kind == Node::Kind::Assert)
+      fail("nothing to repeat");
+    Node node;
+    node.kind = Node::Kind::Repeat;
+    quantifier(node.min, node.max);
+    // Lazy and greedy repeats accept the same values
+    if (!atEnd() && peek() == '?')
+      ++m_pos;
+    // std::regex accepts a repeated quantifier such as a**
+    if (!atEnd() && isQuantifier(peek()))
+      throw NotRegular{};
+    node.children.push_back(std::move(atom));
+    return node;
+  }
+
+  static bool isQuantifier(char c) {
+    return c == '*' || c == '+' || c == '?' || c == '{';
+  }
+
+  void quantifier(int &min, int &max) {
+    char c = m_pattern[m_pos++];
+    if (c == '*') {
+      min = 0;
+      max = -1;
+    } else if (c == '+') {
+      min = 1;
+      max = -1;
+    } else if (c == '?') {
+      min = 0;
+      max = 1;
+    } else {
+      min = number();
+      max = min;
+      if (!atEnd() && peek() == ',') {
+        ++m_pos;
+        max = !atEnd() && peek() == '}' ? -1 : number();
+      }
+      if (atEnd() || peek() != '}')
+        throw NotRegular{};
+      ++m_pos;
+      if (max >= 0 && max < min)
+        fail("invalid {} range");
+      if (min > MAX_REPEAT || max > MAX_REPEAT)
+        throw NotRegular{};
+    }
+  }
+
+  int number() {
+    size_t start = m_pos;
+    int value = 0;
+    while (!atEnd() && std::isdigit(static_cast<unsigned char>(peek())) &&
+           value <= MAX_REPEAT)
+      value = value * 10 + (m_pattern[m_pos++] - '0');
+    if (m_pos == start)
+      throw NotRegular{};
+    return value;
+  }
+
+  Node atom() {
+    Node node;
+    char c = m_pattern[m_pos++];
+    switch (c) {
+    case '(': {
+      if (!atEnd() && peek() == '?') {
+        if (m_pos + 1 >= m_pattern.size() || m_pattern[m_pos + 1] != ':')
+          throw NotRegular{};
+        m_pos += 2;
+      }
+      node = alternation();
+      if (atEnd())
+        fail("missing ')'");
+      ++m_pos;
+      return node;
+    }
+    case '[':
+      node.kind = Node::Kind::Set;
+      node.set = bracket();
+      return node;
+    case '.':
+      node.kind = Node::Kind::Set;
+      node.set = anySet();
+      return node;
+    case '^':
+    case '$':
+      node.kind = Node::Kind::Assert;
+      node.assertion = c == '^' ? Begin : End;
+      return node;
+    case '\\':
+      return escape();
+    case '*':
+    case '+':
+    case '?':
+      --m_pos;
+      fail("nothing to repeat");
+    case '{':
+    case '}':
+    case ']':
+      throw NotRegular{};
+    default:
+      node.kind = Node::Kind::Set;
+      node.set = charSet(static_cast<unsigned char>(c));
+      return node;
+    }
+  }
+
+  // Single character escapes shared by atoms and brackets; false when c
+  // is not one
+  static bool controlEscape(char c, unsigned char &out) {
+    switch (c) {
+    case 'n':
+      out = '\n';
+      return true;
+    case 'r':
+      out = '\r';
+      return true;
+    case 't':
+      out = '\t';
+      return true;
+    case 'f':
+      out = '\f';
+      return true;
+    case 'v':
+      out = '\v';
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // \d \D \w \W \s \S; false when c is not a class escape
+  static bool classEscape(char c, Set &out) {
+    switch (c) {
+    case 'd':
+      out = digitSet();
+      return true;
+    case 'D':
+      out = ~digitSet();
+      return true;
+    case 'w':
+      out = wordSet();
+      return true;
+    case 'W':
+      out = ~wordSet();
+      return true;
+    case 's':
+      out = spaceSet();
+      return true;
+    case 'S':
+      out = ~spaceSet();
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  Node escape() {
+    if (atEnd())
+      fail("trailing backslash");
+    char c = m_pattern[m_pos++];
+    Node node;
+    node.kind = Node::Kind::Set;
+    unsigned char byte;
+    if (classEscape(c, node.set))
+      return node;
+    if (controlEscape(c, byte)) {
+      node.set = charSet(byte);
+      return node;
+    }
+    if (c == 'b' || c == 'B') {
+      node.kind = Node::Kind::Assert;
+      node.assertion = c == 'b' ? WordBoundary : NotWordBoundary;
+      return node;
+    }
+    // Back-references, \x, \u, \c and the rest are left to std::regex
+    if (std::isalnum(static_cast<unsigned char>(c)))
+      throw NotRegular{};
+    node.set = charSet(static_cast<unsigned char>(c));
+    return node;
+  }
+
+  // One member of a bracket: a character, or a class escape into set
+  bool bracketAtom(unsigned char &c, Set &set) {
+    if (atEnd())
+      fail("missing ']'");
+    char raw = m_pattern[m_pos++];
+    if (raw == '[' && !atEnd() &&
+        (peek() == ':' || peek() == '=' || peek() == '.'))
+      throw NotRegular{};
+    if (raw != '\\') {
+      c = static_cast<unsigned char>(raw);
+      return true;
+    }
+    if (atEnd())
+      fail("missing ']'");
+    raw = m_pattern[m_pos++];
+    if (classEscape(raw, set))
+      return false;
+    if (controlEscape(raw, c))
+      return true;
+    if (raw == 'b') {
+      c = '\b';
+      return true;
+    }
+    if (std::isalnum(static_cast<unsigned char>(raw)))
+      throw NotRegular{};
+    c = static_cast<unsigned char>(raw);
+    return true;
+  }
+
+  Set bracket() {
+    bool negate = !atEnd() && peek() == '^';
+    if (negate)
+      ++m_pos;
+    // [] and [^] mean nothing and anything in ECMAScript only
+    if (!atEnd() && peek() == ']')
+      throw NotRegular{};
+    Set set;
+    while (true) {
+      if (atEnd())
+        fail("missing ']'");
+      if (peek() == ']') {
+        ++m_pos;
+        break;
+      }
+      unsigned char from;
+      Set members;
+      if (!bracketAtom(from, members)) {
+        set |= members;
+        continue;
+      }
+      if (m_pos + 1 < m_pattern.size() && peek() == '-' &&
+          m_pattern[m_pos + 1] != ']') {
+        ++m_pos;
+        unsigned char to;
+        if (!bracketAtom(to, members))
+          throw NotRegular{};
+        if (to < from)
+          fail("invalid range in []");
+        set |= rangeSet(from, to);
+      } else {
+        set.set(from);
+      }
+    }
+    return negate ? ~set : set;
+  }
+
+  std::string_view m_pattern;
+  size_t m_pos = 0;
+};
+
+class Compiler {
+public:
+  Compiler(std::vector<Regex::Instruction> &program, std::vector<Set> &sets)
+      : m_program(program), m_sets(sets) {}
+
+  void emit(const Node &node) {
+    if (m_program.size() > MAX_PROGRAM)
+      throw NotRegular{};
+    switch (node.kind) {
+    case Node::Kind::Empty:
+      break;
+    case Node::Kind::Set:
+      m_sets.push_back(node.set);
+      push({Op::Set, 0, static_cast<uint32_t>(m_sets.size() - 1), 0});
+      break;
+    case Node::Kind::Assert:
+      push({Op::Assert, node.assertion, 0, 0});
+      break;
+    case Node::Kind::Concat:
+      for (const auto &child : node.children)
+        emit(child);
+      break;
+    case Node::Kind::Alternate: {
+      std::vector<size_t> jumps;
+      for (size_t i = 0; i + 1 < node.children.size(); ++i) {
+        size_t split = push({Op::Split, 0, 0, 0});
+        m_program[split].x = here();
+        emit(node.children[i]);
+        jumps.push_back(push({Op::Jump, 0, 0, 0}));
+        m_program[split].y = here();
+      }
+      emit(node.children.back());
+      for (size_t jump : jumps)
+        m_program[jump].x = here();
+      break;
+    }
+    case Node::Kind::Repeat: {
+      const Node &child = node.children.front();
+      for (int i = 0; i < node.min; ++i)
+        emit(child);
+      if (node.max < 0) {
+        size_t split = push({Op::Split, 0, 0, 0});
+        m_program[split].x = here();
+        emit(child);
+        push({Op::Jump, 0, static_cast<uint32_t>(split), 0});
+        m_program[split].y = here();
+        break;
+      }
+      std::vector<size_t> splits;
+      for (int i = node.min; i < node.max; ++i) {
+        size_t split = push({Op::Split, 0, 0, 0});
+        m_program[split].x = here();
+        splits.push_back(split);
+        emit(child);
+      }
+      for (size_t split : splits)
+        m_program[split].y = here();
+      break;
+    }
+    }
+  }
+
+private:
+  size_t push(Regex::Instruction instruction) {
+    m_program.push_back(instruction);
+    return m_program.size() - 1;
+  }
+
+  uint32_t here() const { return static_cast<uint32_t>(m_program.size()); }
+
+  std::vector<Regex::Instruction> &m_program;
+  std::vector<Set> &m_sets;
+};
+
+bool isSingleChar(const Node &node) {
+  return node.kind == Node::Kind::Set && node.set.count() == 1;
+}
+
+bool isDotStar(const Node &node) {
+  return node.kind == Node::Kind::Repeat && node.min == 0 && node.max < 0 &&
+         node.children.front().kind == Node::Kind::Set &&
+         node.children.front().set == anySet();
+}
+
+char singleChar(const Node &node) {
+  for (unsigned c = 0; c < 256; ++c) {
+    if (node.set.test(c))
+      return static_cast<char>(c);
+  }
+  return 0;
+}
+
+bool hasLineBreak(std::string_view text) {
+  return text.find_first_of("\n\r") != std::string_view::npos;
+}
+
+} // namespace
+
+Regex::Regex(std::string_view pattern) {
+  Node root;
+  try {
+    root = Parser(pattern).parse();
+  } catch (const NotRegular &) {
+    m_strategy = Strategy::Backtracking;
+  }
+
+  if (m_strategy != Strategy::Backtracking) {
+    // A literal between optional anchors and `.*` is compared directly;
+    // `.` stops at line breaks, which the comparisons check for
+    std::vector<const Node *> parts;
+    if (root.kind == Node::Kind::Concat) {
+      for (const auto &child : root.children)
+        parts.push_back(&child);
+    } else {
+      parts.push_back(&root);
+    }
+    size_t first = 0, last = parts.size();
+    if (first < last && parts[first]->kind == Node::Kind::Assert &&
+        parts[first]->assertion == Begin)
+      ++first;
+    if (first < last && parts[last - 1]->kind == Node::Kind::Assert &&
+        parts[last - 1]->assertion == End)
+      --last;
+    bool leading = first < last && isDotStar(*parts[first]);
+    bool trailing = first + leading < last && isDotStar(*parts[last - 1]);
+    first += leading;
+    last -= trailing;
+    bool literal = true;
+    for (size_t i = first; i < last && literal; ++i) {
+      literal = isSingleChar(*parts[i]);
+      if (literal)
+        m_literal.push_back(singleChar(*parts[i]));
+    }
+    if (literal) {
+      m_strategy = leading && trailing ? Strategy::Substring
+                   : leading           ? Strategy::Suffix
+                   : trailing          ? Strategy::Prefix
+                                       : Strategy::Literal;
+    }
+    // The substring check needs the automaton for values with line breaks
+    if (!literal || m_strategy == Strategy::Substring) {
+      try {
+        Compiler(m_program, m_sets).emit(root);
+        m_program.push_back({Op::Match, 0, 0, 0});
+        if (!literal)
+          m_strategy = Strategy::Automaton;
+      } catch (const NotRegular &) {
+        m_strategy = Strategy::Backtracking;
+      }
+    }
+  }
+
+  if (m_strategy == Strategy::Backtracking) {
+    m_program.clear();
+    m_sets.clear();
+    try {
+      m_fallback = std::make_unique<Fallback>(std::regex(std::string(pattern)));
+    } catch (const std::regex_error &e) {
+      throw std::invalid_argument(e.what());
+    }
+  }
+}
+
+Regex::~Regex() = default;
+
+bool Regex::fullMatch(std::string_view text) const {
+  switch (m_strategy) {
+  case Strategy::Literal:
+    return text == m_literal;
+  case Strategy::Prefix:
+    return text.starts_with(m_literal) &&
+           !hasLineBreak(text.substr(m_literal.size()));
+  case Strategy::Suffix:
+    return text.ends_with(m_literal) &&
+           !hasLineBreak(text.substr(0, text.size() - m_literal.size()));
+  case Strategy::Substring:
+    if (hasLineBreak(text))
+      return runAutomaton(text);
+    return text.find(m_literal) != std::string_view::npos;
+  case Strategy::Automaton:
+    return runAutomaton(text);
+  case Strategy::Backtracking:
+    return std::regex_match(text.begin(), text.end(), m_fallback->regex);
+  }
+  return false;
+}
+
+std::string_view Regex::strategy() const {
+  constexpr std::string_view NAMES[] = {"literal",   "prefix",
+                                        "suffix",    "substring",
+                                        "automaton", "backtracking"};
+  return NAMES[static_cast<size_t>(m_strategy)];
+}
+
+bool Regex::runAutomaton(std::string_view text) const {
+  // Scratch space reused across calls; marks[pc] == generation when pc is
+  // already in the list being built
+  thread_local std::vector<uint32_t> current, next, stack, marks;
+  thread_local uint32_t generation = 0;
+  if (marks.size() < m_program.size())
+    marks.resize(m_program.size());
+  if (generation > UINT32_MAX - text.size() - 2) {
+    std::fill(marks.begin(), marks.end(), 0);
+    generation = 0;
+  }
+
+  // Follow jumps, splits and assertions from pc at position pos
+  auto add = [&](std::vector<uint32_t> &list, uint32_t start, size_t pos) {
+    stack.push_back(start);
+    while (!stack.empty()) {
+      uint32_t pc = stack.back();
+      stack.pop_back();
+      if (marks[pc] == generation)
+        continue;
+      marks[pc] = generation;
+      const Instruction &instruction = m_program[pc];
+      switch (instruction.op) {
+      case Op::Jump:
+        stack.push_back(instruction.x);
+        break;
+      case Op::Split:
+        stack.push_back(instruction.y);
+        stack.push_back(instruction.x);
+        break;
+      case Op::Assert: {
+        auto wordAt = [&](size_t at) {
+          return isWord(static_cast<unsigned char>(text[at]));
+        };
+        bool before = pos > 0 && wordAt(pos - 1);
+        bool after = pos < text.size() && wordAt(pos);
+        bool holds = before == after;
+        if (instruction.assertion == Begin)
+          holds = pos == 0;
+        else if (instruction.assertion == End)
+          holds = pos == text.size();
+        else if (instruction.assertion == WordBoundary)
+          holds = before != after;
+        if (holds)
+          stack.push_back(pc + 1);
+        break;
+      }
+      case Op::Set:
+      case Op::Match:
+        list.push_back(pc);
+        break;
+      }
+    }
+  };
+
+  current.clear();
+  ++generation;
+  add(current, 0, 0);
+  for (size_t pos = 0; pos < text.size() && !current.empty(); ++pos) {
+    unsigned char c = static_cast<unsigned char>(text[pos]);
+    next.clear();
+    ++generation;
+    for (uint32_t pc : current) {
+      const Instruction &instruction = m_program[pc];
+      if (instruction.op == Op::Set && m_sets[instruction.x].test(c))
+        add(next, pc + 1, pos + 1);
+    }
+    current.swap(next);
+  }
+  for (uint32_t pc : current) {
+    if (m_program[pc].op == Op::Match)
+      return true;
+  }
+  return false;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery {
+
+// A regular expression in the ECMAScript syntax of std::regex that has to
+// match a whole value. A literal, optionally with a leading or trailing
+// `.*`, is compared directly; other patterns compile to a Thompson NFA that
+// is simulated without backtracking, in time linear in the value.
+// Back-references and lookaheads are not regular and go to std::regex.
+class Regex {
+public:
+  // Throws std::invalid_argument naming what is wrong with the pattern
+  explicit Regex(std::string_view pattern);
+  ~Regex();
+
+  Regex(const Regex &) = delete;
+  Regex &operator=(const Regex &) = delete;
+
+  bool fullMatch(std::string_view text) const;
+
+  // How values are matched: literal, prefix, suffix, substring, automaton
+  // or backtracking
+  std::string_view strategy() const;
+
+  struct Instruction {
+    enum class Op : uint8_t { Set, Split, Jump, Assert, Match };
+    Op op;
+    uint8_t assertion = 0;
+    uint32_t x = 0;
+    uint32_t y = 0;
+  };
+
+private:
+  enum class Strategy : uint8_t {
+    Literal,
+    Prefix,
+    Suffix,
+    Substring,
+    Automaton,
+    Backtracking
+  };
+  struct Fallback;
+
+  bool runAutomaton(std::string_view text) const;
+
+  Strategy m_strategy = Strategy::Automaton;
+  std::string m_literal;
+  std::vector<Instruction> m_program;
+  std::vector<std::bitset<256>> m_sets;
+  std::unique_ptr<Fallback> m_fallback;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,486 @@
+#include "Schema.hpp"
+#include "PerfectHash.hpp"
+#include <cstddef>
+#include <cstring>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr uint32_t SCHEMA_MAGIC = 0x43535148; // "HQSC"
+constexpr uint16_t SCHEMA_VERSION = 3;
+
+constexpr uint8_t FLAG_DEFAULT = 1 << 0;
+constexpr uint8_t FLAG_MIN = 1 << 1;
+constexpr uint8_t FLAG_MAX = 1 << 2;
+
+// Compiled layout: header, the perfect-hash displacement and slot tables,
+// option records, choice records, then the string table. Strings are interned
+// and NUL-terminated so keys and defaults can be handed to hyprlang straight
+// from the mapping. Records are only decoded when they are looked up.
+struct BinaryHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t optionSize;
+  uint32_t optionCount;
+  uint32_t choiceCount;
+  uint32_t indexSize;
+  uint32_t stringsSize;
+};
+
+struct BinaryString {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct BinaryOption {
+  BinaryString key;
+  uint8_t type;
+  uint8_t flags;
+  uint16_t reserved;
+  int64_t intValue;
+  float floatValue;
+  float vecValue[2];
+  BinaryString stringValue;
+  double min[2];
+  double max[2];
+  uint32_t choiceIndex;
+  uint32_t choiceCount;
+};
+
+bool decodeBound(const nlohmann::json &bound, double out[2]) {
+  if (bound.is_number()) {
+    out[0] = bound.get<double>();
+    return true;
+  }
+  if (bound.is_array() && bound.size() == 2 && bound[0].is_number() &&
+      bound[1].is_number()) {
+    out[0] = bound[0].get<double>();
+    out[1] = bound[1].get<double>();
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+SchemaType schemaTypeFromString(std::string_view type) {
+  if (type == "INT")
+    return SchemaType::Int;
+  if (type == "FLOAT")
+    return SchemaType::Float;
+  if (type == "BOOL")
+    return SchemaType::Bool;
+  if (type == "STRING_SHORT")
+    return SchemaType::StringShort;
+  if (type == "STRING_LONG")
+    return SchemaType::StringLong;
+  if (type == "COLOR")
+    return SchemaType::Color;
+  if (type == "GRADIENT")
+    return SchemaType::Gradient;
+  if (type == "VECTOR")
+    return SchemaType::Vector;
+  if (type == "CHOICE")
+    return SchemaType::Choice;
+  return SchemaType::Unknown;
+}
+
+std::string_view schemaTypeName(SchemaType type) {
+  switch (type) {
+  case SchemaType::Int:
+    return "INT";
+  case SchemaType::Float:
+    return "FLOAT";
+  case SchemaType::Bool:
+    return "BOOL";
+  case SchemaType::StringShort:
+    return "STRING_SHORT";
+  case SchemaType::StringLong:
+    return "STRING_LONG";
+  case SchemaType::Color:
+    return "COLOR";
+  case SchemaType::Gradient:
+    return "GRADIENT";
+  case SchemaType::Vector:
+    return "VECTOR";
+  case SchemaType::Choice:
+    return "CHOICE";
+  case SchemaType::Unknown:
+    break;
+  }
+  return "UNKNOWN";
+}
+
+std::string_view Schema::own(std::string str) {
+  return m_strings.emplace_back(std::move(str));
+}
+
+size_t Schema::size() const {
+  return m_records ? m_optionCount : m_optionView.size();
+}
+
+std::span<const SchemaOption> Schema::options() const {
+  if (m_records)
+    std::call_once(m_decodeOnce, [this] { decodeAll(); });
+  return m_optionView;
+}
+
+std::span<const std::string_view> Schema::choiceTable() const {
+  if (m_records)
+    std::call_once(m_decodeOnce, [this] { decodeAll(); });
+  return m_choiceView;
+}
+
+std::span<const std::string_view>
+Schema::choices(const SchemaOption &option) const {
+  auto table = choiceTable();
+  if (option.choiceIndex + option.choiceCount > table.size())
+    return {};
+  return table.subspan(option.choiceIndex, option.choiceCount);
+}
+
+std::optional<SchemaOption> Schema::find(std::string_view key) const {
+  if (m_displacementView.empty())
+    return std::nullopt;
+  uint32_t index = m_slotView[perfectHashSlot(key, m_displacementView)];
+  SchemaOption option;
+  if (m_records) {
+    if (!decodeOption(index, option))
+      return std::nullopt;
+  } else {
+    option = m_optionView[index];
+  }
+  if (option.key != key)
+    return std::nullopt;
+  return option;
+}
+
+bool Schema::buildIndex(std::string &error) {
+  m_optionView = m_options;
+  m_choiceView = m_choices;
+
+  // hyprlang keeps the first registration of a key, so index only that one
+  std::vector<std::string_view> keys;
+  std::vector<uint32_t> indices;
+  std::unordered_set<std::string_view> seen;
+  for (uint32_t i = 0; i < m_options.size(); ++i) {
+    if (seen.insert(m_options[i].key).second) {
+      keys.push_back(m_options[i].key);
+      indices.push_back(i);
+    }
+  }
+  if (!buildPerfectHash(keys, m_displacements, m_slots)) {
+    error = "Failed to build the schema key index";
+    return false;
+  }
+  for (auto &slot : m_slots)
+    slot = indices[slot];
+  m_displacementView = m_displacements;
+  m_slotView = m_slots;
+  return true;
+}
+
+std::unique_ptr<Schema> Schema::load(const std::string &path,
+                                     std::string &error) {
+  MappedFile file(path);
+  if (!file.isOpen()) {
+    error = "Failed to open schema file: " + path;
+    return nullptr;
+  }
+  uint32_t magic = 0;
+  if (file.size() >= sizeof(magic))
+    std::memcpy(&magic, file.data(), sizeof(magic));
+  if (magic == SCHEMA_MAGIC)
+    return fromBinary(std::move(file), error);
+  return fromJson(file.view(), error);
+}
+
+std::unique_ptr<Schema> Schema::fromJson(std::string_view text,
+                                         std::string &error) {
+  nlohmann::json schemaJson = nlohmann::json::parse(text, nullptr, false);
+  if (schemaJson.is_discarded()) {
+    error = "Failed to parse schema JSON";
+    return nullptr;
+  }
+  if (!schemaJson.contains("hyprlang_schema")) {
+    error = "Invalid schema format: missing 'hyprlang_schema' key";
+    return nullptr;
+  }
+
+  auto schema = std::make_unique<Schema>();
+  for (const auto &option : schemaJson["hyprlang_schema"]) {
+    if (!option.contains("value") || !option.contains("type") ||
+        !option.contains("data") || !option["value"].is_string() ||
+        !option["type"].is_string()) {
+      spdlog::error("Invalid schema option format");
+      continue;
+    }
+
+    SchemaOption opt;
+    opt.key = schema->own(option["value"].get<std::string>());
+    opt.type = schemaTypeFromString(option["type"].get<std::string>());
+    const auto &data = option["data"];
+
+    if (data.contains("default")) {
+      const auto &def = data["default"];
+      switch (opt.type) {
+      case SchemaType::Int:
+      case SchemaType::Bool:
+      case SchemaType::Choice:
+        if (def.is_boolean()) {
+          opt.intValue = def.get<bool>();
+          opt.hasDefault = true;
+        } else if (def.is_number()) {
+          opt.intValue = def.get<int64_t>();
+          opt.hasDefault = true;
+        }
+        break;
+      case SchemaType::Float:
+        if (def.is_number()) {
+          opt.floatValue = def.get<float>();
+          opt.hasDefault = true;
+        }
+        break;
+      case SchemaType::StringShort:
+      case SchemaType::StringLong:
+      case SchemaType::Color:
+      case SchemaType::Gradient:
+        if (def.is_string()) {
+          opt.stringValue = schema->own(def.get<std::string>());
+          opt.hasDefault = true;
+        }
+        break;
+      case SchemaType::Vector:
+        if (def.is_array() && def.size() == 2 && def[0].is_number() &&
+            def[1].is_number()) {
+          opt.vecValue[0] = def[0].get<float>();
+          opt.vecValue[1] = def[1].get<float>();
+          opt.hasDefault = true;
+        }
+        break;
+      case SchemaType::Unknown:
+        break;
+      }
+    }
+
+    if (data.contains("min"))
+      opt.hasMin = decodeBound(data["min"], opt.min);
+    if (data.contains("max"))
+      opt.hasMax = decodeBound(data["max"], opt.max);
+    if (data.contains("choices") && data["choices"].is_array()) {
+      opt.choiceIndex = schema->m_choices.size();
+      for (const auto &choice : data["choices"]) {
+        if (choice.is_string())
+          schema->m_choices.push_back(schema->own(choice.get<std::string>()));
+      }
+      opt.choiceCount = schema->m_choices.size() - opt.choiceIndex;
+    }
+    schema->m_options.push_back(opt);
+  }
+  if (!schema->buildIndex(error))
+    return nullptr;
+  return schema;
+}
+
+std::unique_ptr<Schema> Schema::fromBinary(MappedFile file,
+                                           std::string &error) {
+  BinaryHeader header;
+  if (file.size() < sizeof(header)) {
+    error = "Compiled schema is truncated";
+    return nullptr;
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.version != SCHEMA_VERSION ||
+      header.optionSize != sizeof(BinaryOption)) {
+    error = "Compiled schema has an unsupported version, recompile it";
+    return nullptr;
+  }
+
+  size_t indexStart = sizeof(header);
+  size_t optionsStart =
+      indexStart + size_t(header.indexSize) * 2 * sizeof(uint32_t);
+  size_t choicesStart =
+      optionsStart + size_t(header.optionCount) * sizeof(BinaryOption);
+  size_t stringsStart =
+      choicesStart + size_t(header.choiceCount) * sizeof(BinaryString);
+  if (file.size() < stringsStart ||
+      file.size() - stringsStart < header.stringsSize ||
+      header.indexSize > header.optionCount) {
+    error = "Compiled schema is truncated";
+    return nullptr;
+  }
+
+  // The mapping is page aligned and the header keeps the index tables on a
+  // 4-byte boundary, so they are used in place
+  auto schema = std::make_unique<Schema>();
+  const char *base = file.data();
+  schema->m_displacementView = std::span(
+      reinterpret_cast<const int32_t *>(base + indexStart), header.indexSize);
+  schema->m_slotView = std::span(
+      reinterpret_cast<const uint32_t *>(base + indexStart +
+                                         header.indexSize * sizeof(int32_t)),
+      header.indexSize);
+  schema->m_records = base + optionsStart;
+  schema->m_choiceRecords = base + choicesStart;
+  schema->m_stringTable = base + stringsStart;
+  schema->m_optionCount = header.optionCount;
+  schema->m_choiceCount = header.choiceCount;
+  schema->m_stringsSize = header.stringsSize;
+  schema->m_file = std::move(file);
+  return schema;
+}
+
+bool Schema::decodeString(const char *record, std::string_view &out) const {
+  BinaryString str;
+  std::memcpy(&str, record, sizeof(str));
+  // Every string is followed by its terminating NUL inside the table, and
+  // keys and defaults are handed to hyprlang as C strings
+  if (str.offset > m_stringsSize ||
+      m_stringsSize - str.offset <= str.length ||
+      m_stringTable[str.offset + str.length] != '\0')
+    return false;
+  out = std::string_view(m_stringTable + str.offset, str.length);
+  return true;
+}
+
+bool Schema::decodeOption(uint32_t index, SchemaOption &opt) const {
+  if (index >= m_optionCount)
+    return false;
+  const char *record = m_records + size_t(index) * sizeof(BinaryOption);
+  BinaryOption rec;
+  std::memcpy(&rec, record, sizeof(rec));
+  opt.type = static_cast<SchemaType>(rec.type);
+  opt.hasDefault = rec.flags & FLAG_DEFAULT;
+  opt.hasMin = rec.flags & FLAG_MIN;
+  opt.hasMax = rec.flags & FLAG_MAX;
+  opt.intValue = rec.intValue;
+  opt.floatValue = rec.floatValue;
+  std::memcpy(opt.vecValue, rec.vecValue, sizeof(opt.vecValue));
+  std::memcpy(opt.min, rec.min, sizeof(opt.min));
+  std::memcpy(opt.max, rec.max, sizeof(opt.max));
+  opt.choiceIndex = rec.choiceIndex;
+  opt.choiceCount = rec.choiceCount;
+  return decodeString(record + offsetof(BinaryOption, key), opt.key) &&
+         decodeString(record + offsetof(BinaryOption, stringValue),
+                      opt.stringValue) &&
+         size_t(rec.choiceIndex) + rec.choiceCount <= m_choiceCount;
+}
+
+void Schema::decodeAll() const {
+  m_choices.resize(m_choiceCount);
+  for (uint32_t i = 0; i < m_choiceCount; ++i) {
+    if (!decodeString(m_choiceRecords + i * sizeof(BinaryString),
+                      m_choices[i]))
+      spdlog::error("Compiled schema has a corrupt string table");
+  }
+  m_options.reserve(m_optionCount);
+  for (uint32_t i = 0; i < m_optionCount; ++i) {
+    SchemaOption opt;
+    if (decodeOption(i, opt))
+      m_options.push_back(opt);
+    else
+      spdlog::error("Compiled schema has a corrupt option table");
+  }
+  m_optionView = m_options;
+  m_choiceView = m_choices;
+}
+
+std::string Schema::compile() const {
+  std::string strings;
+  std::unordered_map<std::string_view, BinaryString> interned;
+  auto intern = [&](std::string_view str) {
+    auto it = interned.find(str);
+    if (it != interned.end())
+      return it->second;
+    BinaryString ref{static_cast<uint32_t>(strings.size()),
+                     static_cast<uint32_t>(str.size())};
+    strings.append(str);
+    strings.push_back('\0');
+    interned.emplace(str, ref);
+    return ref;
+  };
+
+  std::vector<BinaryString> choiceRecords;
+  for (auto choice : choiceTable())
+    choiceRecords.push_back(intern(choice));
+
+  std::vector<BinaryOption> optionRecords;
+  for (const auto &opt : options()) {
+    BinaryOption rec;
+    std::memset(&rec, 0, sizeof(rec));
+    rec.key = intern(opt.key);
+    rec.type = static_cast<uint8_t>(opt.type);
+    rec.flags = (opt.hasDefault ? FLAG_DEFAULT : 0) |
+                (opt.hasMin ? FLAG_MIN : 0) | (opt.hasMax ? FLAG_MAX : 0);
+    rec.intValue = opt.intValue;
+    rec.floatValue = opt.floatValue;
+    std::memcpy(rec.vecValue, opt.vecValue, sizeof(rec.vecValue));
+    rec.stringValue = intern(opt.stringValue);
+    std::memcpy(rec.min, opt.min, sizeof(rec.min));
+    std::memcpy(rec.max, opt.max, sizeof(rec.max));
+    rec.choiceIndex = opt.choiceIndex;
+    rec.choiceCount = opt.choiceCount;
+    optionRecords.push_back(rec);
+  }
+
+  BinaryHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = SCHEMA_MAGIC;
+  header.version = SCHEMA_VERSION;
+  header.optionSize = sizeof(BinaryOption);
+  header.optionCount = optionRecords.size();
+  header.choiceCount = choiceRecords.size();
+  header.indexSize = m_displacementView.size();
+  header.stringsSize = strings.size();
+
+  std::string out;
+  out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.append(reinterpret_cast<const char *>(m_displacementView.data()),
+             m_displacementView.size_bytes());
+  out.append(reinterpret_cast<const char *>(m_slotView.data()),
+             m_slotView.size_bytes());
+  out.append(reinterpret_cast<const char *>(optionRecords.data()),
+             optionRecords.size() * sizeof(BinaryOption));
+  out.append(reinterpret_cast<const char *>(choiceRecords.data()),
+             choiceRecords.size() * sizeof(BinaryString));
+  out.append(strings);
+  return out;
+}
+
+bool Schema::registerOption(Hyprlang::CConfig &config,
+                            const SchemaOption &option) {
+  if (!option.hasDefault)
+    return false;
+  // Keys and string defaults are NUL-terminated in both storage formats
+  const char *key = option.key.data();
+  switch (option.type) {
+  case SchemaType::Int:
+  case SchemaType::Bool:
+    config.addConfigValue(key, (Hyprlang::INT)option.intValue);
+    return true;
+  case SchemaType::Float:
+    config.addConfigValue(key, (Hyprlang::FLOAT)option.floatValue);
+    return true;
+  case SchemaType::StringShort:
+  case SchemaType::StringLong:
+  case SchemaType::Color:
+  case SchemaType::Gradient:
+    config.addConfigValue(key, (Hyprlang::STRING)option.stringValue.data());
+    return true;
+  case SchemaType::Vector:
+    config.addConfigValue(
+        key, Hyprlang::VEC2{option.vecValue[0], option.vecValue[1]});
+    return true;
+  case SchemaType::Choice:
+  case SchemaType::Unknown:
+    break;
+  }
+  return false;
+}
+
+} // namespace hyprquery
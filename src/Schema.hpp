@@ -0,0 +1,117 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <deque>
+#include <hyprlang.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery {
+
+enum class SchemaType : uint8_t {
+  Unknown,
+  Int,
+  Float,
+  Bool,
+  StringShort,
+  StringLong,
+  Color,
+  Gradient,
+  Vector,
+  Choice,
+};
+
+SchemaType schemaTypeFromString(std::string_view type);
+std::string_view schemaTypeName(SchemaType type);
+
+// One schema option with its default and bounds already decoded
+struct SchemaOption {
+  std::string_view key;
+  SchemaType type = SchemaType::Unknown;
+  bool hasDefault = false;
+  bool hasMin = false;
+  bool hasMax = false;
+  int64_t intValue = 0;
+  float floatValue = 0;
+  float vecValue[2] = {0, 0};
+  std::string_view stringValue;
+  // Scalar bounds use the first element, VECTOR bounds both. Doubles, so
+  // that INT bounds past 2^24 stay exact.
+  double min[2] = {0, 0};
+  double max[2] = {0, 0};
+  uint32_t choiceIndex = 0;
+  uint32_t choiceCount = 0;
+};
+
+// Option table loaded from the JSON schema, its compiled form, or the
+// tables generated into the binary at build time
+class Schema {
+public:
+  // Load a JSON or compiled schema; the format is detected from the content
+  static std::unique_ptr<Schema> load(const std::string &path,
+                                      std::string &error);
+  static std::unique_ptr<Schema> fromJson(std::string_view text,
+                                          std::string &error);
+  // The Hyprland schema embedded at build time; no file I/O
+  static std::unique_ptr<Schema> builtin();
+
+  // Serialize into the compiled (.hqs) format
+  std::string compile() const;
+
+  // Number of options, without decoding a compiled schema
+  size_t size() const;
+  // Every option; decodes all records of a compiled schema on first use
+  std::span<const SchemaOption> options() const;
+  std::span<const std::string_view> choices(const SchemaOption &option) const;
+  // Perfect-hash lookup that decodes only the matching record
+  std::optional<SchemaOption> find(std::string_view key) const;
+
+  // Raw tables behind choices() and find(), emitted by hyq-schemagen
+  std::span<const std::string_view> choiceTable() const;
+  std::span<const int32_t> displacements() const {
+    return m_displacementView;
+  }
+  std::span<const uint32_t> slots() const { return m_slotView; }
+
+  // Register one option with hyprlang; false if it has no usable default
+  static bool registerOption(Hyprlang::CConfig &config,
+                             const SchemaOption &option);
+
+private:
+  static std::unique_ptr<Schema> fromBinary(MappedFile file,
+                                            std::string &error);
+  std::string_view own(std::string str);
+  bool buildIndex(std::string &error);
+  bool decodeString(const char *record, std::string_view &out) const;
+  bool decodeOption(uint32_t index, SchemaOption &option) const;
+  void decodeAll() const;
+
+  MappedFile m_file;
+  std::deque<std::string> m_strings;
+  std::vector<int32_t> m_displacements;
+  std::vector<uint32_t> m_slots;
+  // Views over either the vectors of this object or the built-in tables
+  std::span<const int32_t> m_displacementView;
+  std::span<const uint32_t> m_slotView;
+
+  // Records of a compiled schema, decoded on demand from the mapping
+  const char *m_records = nullptr;
+  const char *m_choiceRecords = nullptr;
+  const char *m_stringTable = nullptr;
+  uint32_t m_optionCount = 0;
+  uint32_t m_choiceCount = 0;
+  uint32_t m_stringsSize = 0;
+  mutable std::once_flag m_decodeOnce;
+  mutable std::vector<SchemaOption> m_options;
+  mutable std::vector<std::string_view> m_choices;
+  mutable std::span<const SchemaOption> m_optionView;
+  mutable std::span<const std::string_view> m_choiceView;
+};
+
+} // namespace hyprquery
@@ -0,0 +1,181 @@
+// Build-time generator for the built-in schema tables (BuiltinSchema.hpp)
+#include "BinaryIO.hpp"
+#include "MappedFile.hpp"
+#include "Schema.hpp"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <spdlog/fmt/fmt.h>
+
+using namespace hyprquery;
+
+namespace {
+
+std::string cppString(std::string_view str) {
+  std::string out = "\"";
+  for (unsigned char c : str) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+      out.push_back(c);
+    } else if (c < 0x20 || c >= 0x7f) {
+      // Fixed-width octal so a following digit is never absorbed
+      out += fmt::format("\\{:03o}", c);
+    } else {
+      out.push_back(c);
+    }
+  }
+  return out + "\"";
+}
+
+// Hex float literals keep every generated value bit-exact
+std::string cppFloat(float value) { return fmt::format("{:a}f", value); }
+
+std::string cppFloatPair(const float values[2]) {
+  return "{" + cppFloat(values[0]) + ", " + cppFloat(values[1]) + "}";
+}
+
+std::string cppDoublePair(const double values[2]) {
+  return fmt::format("{{{:a}, {:a}}}", values[0], values[1]);
+}
+
+std::string cppType(SchemaType type) {
+  switch (type) {
+  case SchemaType::Int:
+    return "Int";
+  case SchemaType::Float:
+    return "Float";
+  case SchemaType::Bool:
+    return "Bool";
+  case SchemaType::StringShort:
+    return "StringShort";
+  case SchemaType::StringLong:
+    return "StringLong";
+  case SchemaType::Color:
+    return "Color";
+  case SchemaType::Gradient:
+    return "Gradient";
+  case SchemaType::Vector:
+    return "Vector";
+  case SchemaType::Choice:
+    return "Choice";
+  case SchemaType::Unknown:
+    break;
+  }
+  return "Unknown";
+}
+
+bool finite(const SchemaOption &opt) {
+  return std::isfinite(opt.floatValue) && std::isfinite(opt.vecValue[0]) &&
+         std::isfinite(opt.vecValue[1]) && std::isfinite(opt.min[0]) &&
+         std::isfinite(opt.min[1]) && std::isfinite(opt.max[0]) &&
+         std::isfinite(opt.max[1]);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <schema.json> <output.cpp>\n";
+    return 1;
+  }
+
+  MappedFile file(argv[1]);
+  if (!file.isOpen()) {
+    std::cerr << "Error: Failed to open schema file: " << argv[1] << "\n";
+    return 1;
+  }
+  std::string error;
+  auto schema = Schema::fromJson(file.view(), error);
+  if (!schema) {
+    std::cerr << "Error: " << error << "\n";
+    return 1;
+  }
+
+  std::string out;
+  out += "// Generated by hyq-schemagen from schema/hyprland.json; do not "
+         "edit.\n";
+  out += "#include \"BuiltinSchema.hpp\"\n";
+  out += "#include \"PerfectHash.hpp\"\n";
+  out += "#include <array>\n\n";
+  out += "namespace hyprquery::builtin_schema {\n\nnamespace {\n\n";
+
+  auto choiceTable = schema->choiceTable();
+  auto displacements = schema->displacements();
+  auto slots = schema->slots();
+
+  out += fmt::format("constexpr std::array<std::string_view, {}> CHOICES = {{",
+                     choiceTable.size());
+  for (auto choice : choiceTable)
+    out += "\n    " + cppString(choice) + ",";
+  out += "\n};\n\n";
+
+  out += fmt::format("constexpr std::array<SchemaOption, {}> OPTIONS = {{",
+                     schema->options().size());
+  for (const auto &opt : schema->options()) {
+    if (!finite(opt)) {
+      std::cerr << "Error: Non-finite number in option " << opt.key << "\n";
+      return 1;
+    }
+    out += fmt::format(
+        "\n    SchemaOption{{.key = {},\n"
+        "                 .type = SchemaType::{},\n"
+        "                 .hasDefault = {},\n"
+        "                 .hasMin = {},\n"
+        "                 .hasMax = {},\n"
+        "                 .intValue = {}LL,\n"
+        "                 .floatValue = {},\n"
+        "                 .vecValue = {},\n"
+        "                 .stringValue = {},\n"
+        "                 .min = {},\n"
+        "                 .max = {},\n"
+        "                 .choiceIndex = {},\n"
+        "                 .choiceCount = {}}},",
+        cppString(opt.key), cppType(opt.type), opt.hasDefault, opt.hasMin,
+        opt.hasMax, opt.intValue, cppFloat(opt.floatValue),
+        cppFloatPair(opt.vecValue), cppString(opt.stringValue),
+        cppDoublePair(opt.min), cppDoublePair(opt.max), opt.choiceIndex,
+        opt.choiceCount);
+  }
+  out += "\n};\n\n";
+
+  out += fmt::format("constexpr std::array<int32_t, {}> DISPLACEMENTS = {{",
+                     displacements.size());
+  for (size_t i = 0; i < displacements.size(); ++i)
+    out += (i % 8 ? " " : "\n    ") + fmt::format("{},", displacements[i]);
+  out += "\n};\n\n";
+
+  out += fmt::format("constexpr std::array<uint32_t, {}> SLOTS = {{",
+                     slots.size());
+  for (size_t i = 0; i < slots.size(); ++i)
+    out += (i % 8 ? " " : "\n    ") + fmt::format("{},", slots[i]);
+  out += "\n};\n\n";
+
+  // Reject a stale or corrupt index when the tables are compiled
+  out += "consteval bool indexIsPerfect() {\n"
+         "  for (uint32_t slot = 0; slot < SLOTS.size(); ++slot) {\n"
+         "    const auto &key = OPTIONS[SLOTS[slot]].key;\n"
+         "    if (perfectHashSlot(key, DISPLACEMENTS) != slot)\n"
+         "      return false;\n"
+         "  }\n"
+         "  return true;\n"
+         "}\n"
+         "static_assert(indexIsPerfect());\n\n";
+
+  out += "} // namespace\n\n";
+  out += fmt::format("const uint64_t SOURCE_HASH = 0x{:016x}ULL;\n\n",
+                     fnv1a(file.view()));
+  out += "std::span<const SchemaOption> options() { return OPTIONS; }\n"
+         "std::span<const std::string_view> choices() { return CHOICES; }\n"
+         "std::span<const int32_t> displacements() { return DISPLACEMENTS; "
+         "}\n"
+         "std::span<const uint32_t> slots() { return SLOTS; }\n\n";
+  out += "} // namespace hyprquery::builtin_schema\n";
+
+  std::ofstream output(argv[2], std::ios::binary | std::ios::trunc);
+  output << out;
+  if (!output) {
+    std::cerr << "Error: Failed to write " << argv[2] << "\n";
+    return 1;
+  }
+  return 0;
+}
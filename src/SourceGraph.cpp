@@ -0,0 +1,257 @@
+#include "SourceGraph.hpp"
+#include "BinaryIO.hpp"
+#include "ConfigCache.hpp"
+#include "ConfigScanner.hpp"
+#include "InputFiles.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <unordered_set>
+
+namespace hyprquery {
+
+std::vector<std::string> SourceGraph::Summary::definedNames() const {
+  std::vector<std::string> names;
+  for (const auto &def : definitions)
+    names.push_back(def.name);
+  std::sort(names.begin(), names.end());
+  names.erase(std::unique(names.begin(), names.end()), names.end());
+  return names;
+}
+
+bool SourceGraph::Summary::defines(std::string_view name) const {
+  return std::any_of(definitions.begin(), definitions.end(),
+                     [&](const Definition &def) { return def.name == name; });
+}
+
+bool SourceGraph::Summary::refersTo(std::string_view name) const {
+  return std::binary_search(references.begin(), references.end(), name);
+}
+
+bool SourceGraph::read(const std::string &path, uint64_t &hash,
+                       Summary &summary) {
+  auto file = InputFiles::map(path);
+  if (!file->isOpen())
+    return false;
+  hash = fnv1a(file->view());
+  summary = {};
+
+  std::unordered_set<std::string> usedUndefined;
+  auto noteReferences = [&](std::string_view value) {
+    std::vector<std::string> names;
+    ConfigCache::collectEnvReferences(value, names);
+    for (auto &name : names) {
+      if (!summary.defines(name))
+        usedUndefined.insert(name);
+      summary.references.push_back(std::move(name));
+    }
+  };
+  bool understood =
+      ConfigScanner::scan(file->view(), [&](const ScannedLine &line) {
+        noteReferences(line.value);
+        if (line.isVariable) {
+          std::string name(line.key.substr(1));
+          // The first parse saw an outside value here, a second one would
+          // see this file's own
+          if (usedUndefined.contains(name))
+            summary.selfContained = false;
+          summary.definitions.push_back(
+              {name, std::string(line.value), summary.sourceLines});
+        } else if (line.key == "source") {
+          ++summary.sourceLines;
+        } else if (line.key.ends_with(":source")) {
+          summary.nestedSource = true;
+        } else {
+          summary.keys.emplace_back(line.key);
+          // Special categories can create a new instance on every parse
+          if (line.key.find('[') != std::string_view::npos)
+            summary.selfContained = false;
+        }
+      });
+  summary.selfContained = summary.selfContained && understood;
+
+  auto sortUnique = [](std::vector<std::string> &names) {
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+  };
+  sortUnique(summary.keys);
+  sortUnique(summary.references);
+  return true;
+}
+
+void SourceGraph::clear() {
+  m_nodes.clear();
+  m_stack.clear();
+  m_sourceCounts.clear();
+  m_valid = true;
+}
+
+void SourceGraph::enter(const std::string &path) {
+  Node node;
+  node.path = path;
+  if (!m_stack.empty()) {
+    node.parent = m_stack.back();
+    if (m_sourceCounts.back() == 0)
+      m_valid = false;
+    else
+      node.sourceIndex = m_sourceCounts.back() - 1;
+  }
+  // A file sourced twice is applied twice; keep such graphs cold
+  if (contains(path) || !read(path, node.hash, node.summary) ||
+      node.summary.nestedSource)
+    m_valid = false;
+  m_stack.push_back(m_nodes.size());
+  m_sourceCounts.push_back(0);
+  m_nodes.push_back(std::move(node));
+}
+
+void SourceGraph::leave(bool clean) {
+  if (m_stack.empty())
+    return;
+  m_nodes[m_stack.back()].clean = clean;
+  m_stack.pop_back();
+  m_sourceCounts.pop_back();
+}
+
+void SourceGraph::sourceLine() {
+  if (!m_sourceCounts.empty())
+    ++m_sourceCounts.back();
+}
+
+void SourceGraph::verify() {
+  for (const auto &node : m_nodes) {
+    if (!isCurrent(node.path)) {
+      spdlog::debug("[graph] {} changed while it was parsed", node.path);
+      m_valid = false;
+    }
+  }
+}
+
+bool SourceGraph::contains(const std::string &path) const {
+  return std::any_of(m_nodes.begin(), m_nodes.end(),
+                     [&](const Node &node) { return node.path == path; });
+}
+
+bool SourceGraph::isCurrent(const std::string &path) const {
+  for (const auto &node : m_nodes) {
+    if (node.path != path)
+      continue;
+    auto file = InputFiles::map(path);
+    return file->isOpen() && fnv1a(file->view()) == node.hash;
+  }
+  return false;
+}
+
+size_t SourceGraph::reachedThrough(size_t index, size_t ancestor) const {
+  for (size_t child = index; m_nodes[child].parent != NO_PARENT;
+       child = m_nodes[child].parent) {
+    if (m_nodes[child].parent == ancestor)
+      return m_nodes[child].sourceIndex;
+  }
+  return NO_PARENT;
+}
+
+bool SourceGraph::canReparse(
+    size_t index, const Summary &next,
+    const std::vector<const Summary *> &current) const {
+  const Node &node = m_nodes[index];
+  const Summary &prev = node.summary;
+  // Only leaves whose shape is unchanged: the same keys and variables, so
+  // nothing a cold parse would register or reset differs
+  if (node.parent == NO_PARENT || !node.clean || !prev.selfContained ||
+      !next.selfContained || prev.sourceLines > 0 || next.sourceLines > 0 ||
+      prev.keys != next.keys || prev.definedNames() != next.definedNames())
+    return false;
+
+  auto definitionsOf = [](const Summary &summary, std::string_view name) {
+    std::vector<std::pair<std::string_view, size_t>> defs;
+    for (const auto &def : summary.definitions) {
+      if (def.name == name)
+        defs.emplace_back(def.value, def.sourcesBefore);
+    }
+    return defs;
+  };
+
+  for (size_t other = 0; other < m_nodes.size(); ++other) {
+    if (other == index)
+      continue;
+    const Summary &summary = *current[other];
+
+    // Another file's assignment of the same key may come later
+    for (const auto &key : next.keys) {
+      if (std::binary_search(summary.keys.begin(), summary.keys.end(), key))
+        return false;
+    }
+
+    for (const auto &name : next.definedNames()) {
+      if (summary.defines(name))
+        return false;
+      // Values other files expanded from it must stay what they were
+      if (summary.refersTo(name)) {
+        auto defs = definitionsOf(next, name);
+        if (defs != definitionsOf(prev, name))
+          return false;
+        for (const auto &[value, sourcesBefore] : defs) {
+          if (value.find('$') != std::string_view::npos)
+            return false;
+        }
+      }
+    }
+
+    // Variables from other files must have had their final value already
+    // when this file was first parsed
+    for (const auto &name : next.references) {
+      if (next.defines(name) || !summary.defines(name))
+        continue;
+      size_t through = reachedThrough(index, other);
+      if (through == NO_PARENT) {
+        if (other > index)
+          return false;
+        continue;
+      }
+      for (const auto &def : summary.definitions) {
+        if (def.name == name && def.sourcesBefore > through)
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::optional<std::vector<std::string>> SourceGraph::update() {
+  if (!m_valid || m_nodes.empty())
+    return std::nullopt;
+
+  std::vector<uint64_t> hashes(m_nodes.size());
+  std::vector<Summary> summaries(m_nodes.size());
+  std::vector<const Summary *> current(m_nodes.size());
+  std::vector<size_t> changed;
+  for (size_t i = 0; i < m_nodes.size(); ++i) {
+    current[i] = &m_nodes[i].summary;
+    auto file = InputFiles::map(m_nodes[i].path);
+    if (!file->isOpen())
+      return std::nullopt;
+    if (fnv1a(file->view()) == m_nodes[i].hash)
+      continue;
+    if (!read(m_nodes[i].path, hashes[i], summaries[i]))
+      return std::nullopt;
+    current[i] = &summaries[i];
+    changed.push_back(i);
+  }
+
+  for (size_t index : changed) {
+    if (!canReparse(index, summaries[index], current)) {
+      spdlog::debug("[graph] {} needs a full parse", m_nodes[index].path);
+      return std::nullopt;
+    }
+  }
+
+  std::vector<std::string> paths;
+  for (size_t index : changed) {
+    m_nodes[index].hash = hashes[index];
+    m_nodes[index].summary = std::move(summaries[index]);
+    paths.push_back(m_nodes[index].path);
+  }
+  return paths;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery {
+
+// Which file sourced which during one parse, with the content hash and a
+// scan of every file. Used to decide whether changed files can be parsed
+// again on top of the previous values instead of starting cold.
+class SourceGraph {
+public:
+  void clear();
+
+  // Record a file as it is about to be parsed, below the file on top, and
+  // whether its own lines parsed without an error once it is done
+  void enter(const std::string &path);
+  void leave(bool clean);
+
+  // Count one source= line of the file on top; called before its matches
+  // are entered
+  void sourceLine();
+
+  // Re-hash every file after the parse; a file that changed while it was
+  // parsed makes the graph unusable for in-place updates
+  void verify();
+
+  // Changed files, in parse order, when re-parsing just those on top of
+  // the current values gives the same result as a cold parse; nothing
+  // when a full parse is needed. On success the graph describes the new
+  // content.
+  std::optional<std::vector<std::string>> update();
+
+  bool contains(const std::string &path) const;
+  size_t size() const { return m_nodes.size(); }
+
+  // True while the hash recorded for path matches the file
+  bool isCurrent(const std::string &path) const;
+
+private:
+  struct Definition {
+    std::string name;
+    std::string value;
+    // source= lines of the file that precede the definition
+    size_t sourcesBefore = 0;
+  };
+
+  // What a file assigns and refers to, as far as re-parsing it matters
+  struct Summary {
+    // Scanned cleanly and never uses one of its own variables before
+    // defining it
+    bool selfContained = true;
+    bool nestedSource = false;
+    size_t sourceLines = 0;
+    std::vector<std::string> keys;
+    std::vector<Definition> definitions;
+    std::vector<std::string> references;
+
+    std::vector<std::string> definedNames() const;
+    bool defines(std::string_view name) const;
+    bool refersTo(std::string_view name) const;
+  };
+
+  struct Node {
+    std::string path;
+    size_t parent = NO_PARENT;
+    // Index of the parent's source= line that reached this file
+    size_t sourceIndex = 0;
+    uint64_t hash = 0;
+    // Parsed without an error; errors of other files are kept as they are
+    // by an in-place parse, this file's would be lost
+    bool clean = false;
+    Summary summary;
+  };
+
+  static constexpr size_t NO_PARENT = static_cast<size_t>(-1);
+
+  static bool read(const std::string &path, uint64_t &hash, Summary &summary);
+  bool canReparse(size_t index, const Summary &next,
+                  const std::vector<const Summary *> &current) const;
+  // Source line index in ancestor through which index was reached, or
+  // NO_PARENT if ancestor is not an ancestor of index
+  size_t reachedThrough(size_t index, size_t ancestor) const;
+
+  std::vector<Node> m_nodes;
+  std::vector<size_t> m_stack;
+  std::vector<size_t> m_sourceCounts;
+  bool m_valid = true;
+};
+
+} // namespace hyprquery
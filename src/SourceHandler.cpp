@@ -1,23 +1,41 @@
 #include "SourceHandler.hpp"
 #include "ConfigUtils.hpp"
-#include <cstring>
+#include "PathCache.hpp"
+#include "Profiler.hpp"
 
 #include <glob.h>
-#include <memory>
 #include <spdlog/spdlog.h>
-#include <wordexp.h>
 
 namespace hyprquery {
 
-Hyprlang::CConfig *SourceHandler::s_pConfig = nullptr;
-std::string SourceHandler::s_configDir = "";
-bool SourceHandler::s_initialized = false;
+namespace {
 
-void SourceHandler::setConfigDir(const std::string &dir) { s_configDir = dir; }
+thread_local SourceContext *t_context = nullptr;
 
-std::string SourceHandler::getConfigDir() { return s_configDir; }
+} // namespace
 
-bool SourceHandler::isInitialized() { return s_initialized; }
+SourceHandler::Scope::Scope(SourceContext &context) : m_previous(t_context) {
+  t_context = &context;
+}
+
+SourceHandler::Scope::~Scope() { t_context = m_previous; }
+
+SourceContext *SourceHandler::context() { return t_context; }
+
+void SourceHandler::trackGlobPattern(SourceContext &context,
+                                     const std::string &pattern) {
+  std::filesystem::path patternPath(pattern);
+  std::string dir = patternPath.parent_path().string();
+  if (dir.find_first_of("*?[") != std::string::npos) {
+    context.dependenciesComplete = false;
+    return;
+  }
+  // A wildcard file name means adding or removing a file in the directory
+  // changes the match set, which only the directory mtime reflects
+  if (patternPath.filename().string().find_first_of("*?[") !=
+      std::string::npos)
+    context.dependencies.push_back(FileStamp::capture(dir));
+}
 
 std::string SourceHandler::expandEnvVars(const std::string &path) {
 
@@ -30,7 +48,8 @@ std::string SourceHandler::expandEnvVars(const std::string &path) {
 }
 
 std::vector<std::filesystem::path>
-SourceHandler::resolvePath(const std::string &filePath) {
+SourceHandler::resolvePath(const std::string &filePath,
+                           const std::string &baseDir) {
   std::vector<std::filesystem::path> paths;
 
   std::string normalizedPath = ConfigUtils::normalizePath(filePath);
@@ -42,11 +61,9 @@ SourceHandler::resolvePath(const std::string &filePath) {
     return paths;
   }
 
-  glob_t glob_result;
-  memset(&glob_result, 0, sizeof(glob_t));
-
-  int ret = glob(normalizedPath.c_str(), GLOB_TILDE | GLOB_BRACE, nullptr,
-                 &glob_result);
+  std::vector<std::string> matches;
+  int ret =
+      PathCache::glob(normalizedPath, GLOB_TILDE | GLOB_BRACE, matches);
 
   if (ret != 0) {
     if (ret == GLOB_NOMATCH) {
@@ -56,33 +73,28 @@ SourceHandler::resolvePath(const std::string &filePath) {
     }
 
     std::filesystem::path fallbackPath(normalizedPath);
-    if (std::filesystem::exists(fallbackPath.parent_path())) {
+    if (PathCache::status(fallbackPath.parent_path().string()).exists) {
       paths.push_back(fallbackPath);
     }
-    globfree(&glob_result);
     return paths;
   }
 
-  for (size_t i = 0; i < glob_result.gl_pathc; ++i) {
-    std::string pathStr = glob_result.gl_pathv[i];
-    std::filesystem::path fsPath(pathStr);
-    if (fsPath.is_relative() || fsPath.string().find("./") == 0) {
-      fsPath = std::filesystem::weakly_canonical(s_configDir / fsPath);
-    } else {
-      fsPath = std::filesystem::weakly_canonical(fsPath);
-    }
-    if (std::filesystem::exists(fsPath.parent_path())) {
-      paths.push_back(fsPath);
+  for (const auto &match : matches) {
+    std::filesystem::path fsPath(match);
+    if (fsPath.is_relative())
+      fsPath = baseDir / fsPath;
+    // Matches exist, so only a race leaves them without a canonical form
+    std::string canonical = PathCache::canonical(fsPath.string());
+    if (!canonical.empty()) {
+      paths.push_back(canonical);
     } else {
-      spdlog::warn("Directory does not exist: {}",
-                   fsPath.parent_path().string());
+      spdlog::warn("Path vanished while resolving: {}", fsPath.string());
     }
   }
-  globfree(&glob_result);
 
   spdlog::debug("Resolved paths: ");
   for (const auto &p : paths) {
-    spdlog::debug("PATHS: {}  ::: {}", s_configDir, p.string());
+    spdlog::debug("PATHS: {}  ::: {}", baseDir, p.string());
   }
 
   return paths;
@@ -91,33 +103,38 @@ SourceHandler::resolvePath(const std::string &filePath) {
 Hyprlang::CParseResult SourceHandler::handleSource(const char *command,
                                                    const char *rawpath) {
   Hyprlang::CParseResult result;
+  if (!t_context) {
+    result.setError("source= outside of a parse");
+    return result;
+  }
+  SourceContext &context = *t_context;
   std::string path = rawpath;
+  if (context.sourceGraph)
+    context.sourceGraph->sourceLine();
 
   if (path.length() < 2) {
     result.setError("source= path too short or empty");
     return result;
   }
 
-  std::unique_ptr<glob_t, void (*)(glob_t *)> glob_buf{
-      static_cast<glob_t *>(calloc(1, sizeof(glob_t))), [](glob_t *g) {
-        if (g) {
-          globfree(g);
-          free(g);
-        }
-      }};
-
   std::string absPath;
   if (path[0] == '~') {
     const char *home = getenv("HOME");
     absPath = home ? std::string(home) + path.substr(1) : path;
   } else if (path[0] != '/') {
-    absPath = s_configDir + "/" + path;
+    absPath = context.configDir + "/" + path;
   } else {
     absPath = path;
   }
 
-  int r = glob(absPath.c_str(), GLOB_TILDE, nullptr, glob_buf.get());
+  if (context.trackDependencies)
+    trackGlobPattern(context, absPath);
+
+  std::vector<std::string> matches;
+  int r = PathCache::glob(absPath, GLOB_TILDE, matches);
   if (r != 0) {
+    if (context.trackDependencies)
+      context.dependencies.push_back(FileStamp::capture(absPath));
     std::string err = std::string("source= globbing error: ") +
                       (r == GLOB_NOMATCH   ? "found no match"
                        : r == GLOB_ABORTED ? "read error"
@@ -129,10 +146,19 @@ Hyprlang::CParseResult SourceHandler::handleSource(const char *command,
 
   std::string errorsFromParsing;
 
-  for (size_t i = 0; i < glob_buf->gl_pathc; i++) {
-    std::string value = glob_buf->gl_pathv[i];
-    if (!std::filesystem::is_regular_file(value)) {
-      if (std::filesystem::exists(value)) {
+  // Start reading every match now, they are still parsed one by one below
+  if (context.prefetcher) {
+    for (const auto &match : matches)
+      context.prefetcher->prefetch(match, true);
+  }
+
+  for (const auto &value : matches) {
+    auto status = PathCache::status(value);
+    if (context.trackDependencies)
+      context.dependencies.push_back(
+          FileStamp::fromStat(value, status.exists ? &status.st : nullptr));
+    if (!status.isFile()) {
+      if (status.exists) {
         spdlog::warn("source= skipping non-file {}", value);
         continue;
       }
@@ -142,12 +168,24 @@ Hyprlang::CParseResult SourceHandler::handleSource(const char *command,
       return result;
     }
 
-    std::string configDirBackup = s_configDir;
-    s_configDir = std::filesystem::path(value).parent_path().string();
-
-    auto parseResult = s_pConfig->parseFile(value.c_str());
-
-    s_configDir = configDirBackup;
+    std::string configDirBackup = context.configDir;
+    context.configDir = std::filesystem::path(value).parent_path().string();
+
+    if (context.sourceGraph)
+      context.sourceGraph->enter(value);
+    if (context.keywords)
+      context.keywords->enter(value);
+    ProfileSpan span("source", value);
+    Profiler::count(ProfileCounter::FilesSourced);
+    Profiler::count(ProfileCounter::BytesCopied, status.st.st_size);
+    auto parseResult = context.config->parseFile(value.c_str());
+    span.finish();
+    if (context.sourceGraph)
+      context.sourceGraph->leave(!parseResult.error);
+    if (context.keywords)
+      context.keywords->leave();
+
+    context.configDir = configDirBackup;
 
     if (parseResult.error && errorsFromParsing.empty())
       errorsFromParsing += parseResult.getError();
@@ -159,9 +197,6 @@ Hyprlang::CParseResult SourceHandler::handleSource(const char *command,
 }
 
 void SourceHandler::registerHandler(Hyprlang::CConfig *config) {
-  s_pConfig = config;
-  s_initialized = true;
-
   Hyprlang::SHandlerOptions options;
   options.allowFlags = false;
 
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "ConfigCache.hpp"
+#include "IoPrefetcher.hpp"
+#include "KeywordStore.hpp"
+#include "SourceGraph.hpp"
 #include <filesystem>
 #include <hyprlang.hpp>
 #include <spdlog/spdlog.h>
@@ -8,9 +12,45 @@
 
 namespace hyprquery {
 
-// Forward declarations
+// State of one parse as seen by source= lines. Every config being parsed
+// has its own, so parses on different threads never share anything.
+struct SourceContext {
+  Hyprlang::CConfig *config = nullptr;
+  // Directory relative source= paths resolve against
+  std::string configDir;
+  // Record a stamp for every file and directory a source= line touches
+  bool trackDependencies = false;
+  std::vector<FileStamp> dependencies;
+  // False when a source= glob has wildcards in its directory part, which
+  // can not be invalidated by stamping a single directory
+  bool dependenciesComplete = true;
+  // Queue every file a source= glob matches before parsing them in order
+  IoPrefetcher *prefetcher = nullptr;
+  // Record every sourced file below its parent
+  SourceGraph *sourceGraph = nullptr;
+  // Capture repeated keywords along with the file they come from
+  KeywordStore *keywords = nullptr;
+};
+
 class SourceHandler {
 public:
+  // hyprlang handlers are plain function pointers, so the handler finds the
+  // context of the parse running on its thread through a Scope
+  class Scope {
+  public:
+    explicit Scope(SourceContext &context);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    SourceContext *m_previous;
+  };
+
+  // The context of the parse running on this thread, or null
+  static SourceContext *context();
+
   // Register the source handler with a config instance
   static void registerHandler(Hyprlang::CConfig *config);
 
@@ -18,24 +58,15 @@ public:
   static Hyprlang::CParseResult handleSource(const char *command,
                                              const char *value);
 
-  // Set the current directory for path resolution
-  static void setConfigDir(const std::string &dir);
-
-  // Get the current config directory
-  static std::string getConfigDir();
-
-  // Path utility functions
+  // Path utility functions; relative glob matches are taken relative to
+  // baseDir
   static std::vector<std::filesystem::path>
-  resolvePath(const std::string &path);
+  resolvePath(const std::string &path, const std::string &baseDir = "");
   static std::string expandEnvVars(const std::string &path);
 
-  // Check if the source handler has been initialized
-  static bool isInitialized();
-
 private:
-  static Hyprlang::CConfig *s_pConfig;
-  static std::string s_configDir;
-  static bool s_initialized;
+  static void trackGlobPattern(SourceContext &context,
+                               const std::string &pattern);
 };
 
-} // namespace hyprquery
\ No newline at end of file
+} // namespace hyprquery
@@ -0,0 +1,236 @@
+#include "Validator.hpp"
+#include <charconv>
+#include <filesystem>
+#include <spdlog/fmt/fmt.h>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr std::string_view ERROR_PREFIX = "Config error in file ";
+constexpr std::string_view AT_LINE = " at line ";
+
+// "in [min, max]", "at least min" or "at most max" for one component
+std::string bounds(const SchemaOption &option, size_t component) {
+  if (option.hasMin && option.hasMax)
+    return fmt::format("in [{}, {}]", option.min[component],
+                       option.max[component]);
+  if (option.hasMin)
+    return fmt::format("at least {}", option.min[component]);
+  return fmt::format("at most {}", option.max[component]);
+}
+
+// INT values are compared exactly, as doubles
+bool inBounds(const SchemaOption &option, size_t component, double value) {
+  return !(option.hasMin && value < option.min[component]) &&
+         !(option.hasMax && value > option.max[component]);
+}
+
+// FLOAT and VEC2 values were widened from single precision, so they are
+// compared in it
+bool inFloatBounds(const SchemaOption &option, size_t component,
+                   double value) {
+  auto single = static_cast<float>(value);
+  return !(option.hasMin &&
+           single < static_cast<float>(option.min[component])) &&
+         !(option.hasMax && single > static_cast<float>(option.max[component]));
+}
+
+std::optional<double> toNumber(std::string_view text) {
+  double number = 0;
+  auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), number);
+  if (ec != std::errc() || end != text.data() + text.size())
+    return std::nullopt;
+  return number;
+}
+
+// Options without a usable default are registered as STRING placeholders,
+// so their text is converted here; nullopt when it is not of the type
+std::optional<Value> fromText(SchemaType type, const std::string &text) {
+  switch (type) {
+  case SchemaType::Int:
+  case SchemaType::Bool:
+    if (auto integer = ConfigUtils::configStringToInt(text))
+      return *integer;
+    return std::nullopt;
+  case SchemaType::Float:
+    if (auto number = toNumber(text))
+      return *number;
+    return std::nullopt;
+  case SchemaType::Vector: {
+    // "x y" or "x, y"
+    size_t split = text.find_first_of(" ,");
+    if (split == std::string::npos)
+      return std::nullopt;
+    size_t next = text.find_first_not_of(" ,", split);
+    if (next == std::string::npos)
+      return std::nullopt;
+    auto x = toNumber(std::string_view(text).substr(0, split));
+    auto y = toNumber(std::string_view(text).substr(next));
+    if (!x || !y)
+      return std::nullopt;
+    return Vec2{*x, *y};
+  }
+  default:
+    return text;
+  }
+}
+
+std::string_view typeDescription(SchemaType type) {
+  switch (type) {
+  case SchemaType::Int:
+    return "an integer";
+  case SchemaType::Bool:
+    return "a boolean";
+  case SchemaType::Float:
+    return "a number";
+  default:
+    return "two numbers";
+  }
+}
+
+std::string choiceList(const Schema &schema, const SchemaOption &option) {
+  std::string list;
+  auto names = schema.choices(option);
+  for (size_t i = 0; i < names.size(); ++i)
+    list += fmt::format("{}{} ({})", i ? ", " : "", i, names[i]);
+  return list;
+}
+
+} // namespace
+
+std::optional<Violation> checkValue(const Schema &schema,
+                                    const SchemaOption &option,
+                                    const QueryResult &result) {
+  Violation violation;
+  violation.key = result.key;
+  violation.value = result.value;
+  Value value = result.value;
+  if (auto *text = std::get_if<std::string>(&value);
+      text && option.type != SchemaType::Choice) {
+    auto converted = fromText(option.type, *text);
+    if (!converted) {
+      violation.kind = "type";
+      violation.message =
+          fmt::format("expected {}", typeDescription(option.type));
+      return violation;
+    }
+    value = std::move(*converted);
+    violation.value = value;
+  }
+  switch (option.type) {
+  case SchemaType::Bool:
+    if (auto *integer = std::get_if<int64_t>(&value);
+        integer && *integer != 0 && *integer != 1) {
+      violation.kind = "type";
+      violation.message = "expected a boolean";
+      return violation;
+    }
+    break;
+  case SchemaType::Int:
+    if (auto *integer = std::get_if<int64_t>(&value);
+        integer && !inBounds(option, 0, static_cast<double>(*integer))) {
+      violation.kind = "range";
+      violation.message = "expected a value " + bounds(option, 0);
+      return violation;
+    }
+    break;
+  case SchemaType::Float:
+    if (auto *real = std::get_if<double>(&value);
+        real && !inFloatBounds(option, 0, *real)) {
+      violation.kind = "range";
+      violation.message = "expected a value " + bounds(option, 0);
+      return violation;
+    }
+    break;
+  case SchemaType::Vector:
+    if (auto *vec = std::get_if<Vec2>(&value);
+        vec && !(inFloatBounds(option, 0, vec->x) &&
+                 inFloatBounds(option, 1, vec->y))) {
+      violation.kind = "range";
+      violation.message = fmt::format("expected x {} and y {}",
+                                      bounds(option, 0), bounds(option, 1));
+      return violation;
+    }
+    break;
+  case SchemaType::Color:
+  case SchemaType::Gradient:
+    // Registered as strings, so hyprlang accepts any text
+    if (auto *text = std::get_if<std::string>(&value)) {
+      bool color = option.type == SchemaType::Color;
+      if (color ? !parseColor(*text) : !parseGradient(*text)) {
+        violation.kind = "type";
+        violation.message = color ? "expected a color" : "expected a gradient";
+        return violation;
+      }
+    }
+    break;
+  case SchemaType::Choice: {
+    // Choices are not registered with hyprlang, their text is checked here
+    int64_t index = -1;
+    if (auto *integer = std::get_if<int64_t>(&value)) {
+      index = *integer;
+    } else if (auto *text = std::get_if<std::string>(&value)) {
+      auto [end, ec] =
+          std::from_chars(text->data(), text->data() + text->size(), index);
+      if (ec != std::errc() || end != text->data() + text->size())
+        index = -1;
+    }
+    if (index < 0 || index >= option.choiceCount) {
+      violation.kind = "choice";
+      violation.message = "expected one of " + choiceList(schema, option);
+      return violation;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return std::nullopt;
+}
+
+std::vector<Violation> parseErrorViolations(std::string_view error,
+                                            const std::string &configPath) {
+  std::vector<Violation> violations;
+  while (!error.empty()) {
+    size_t newline = error.find('\n');
+    std::string_view line = error.substr(0, newline);
+    error.remove_prefix(newline == std::string_view::npos ? error.size()
+                                                          : newline + 1);
+    if (line.empty())
+      continue;
+
+    // An error in a sourced file is wrapped in one for the source= line
+    Violation violation;
+    violation.kind = "parse";
+    violation.file = configPath;
+    violation.message = line;
+    if (size_t start = line.rfind(ERROR_PREFIX);
+        start != std::string_view::npos) {
+      std::string_view rest = line.substr(start + ERROR_PREFIX.size());
+      size_t at = rest.find(AT_LINE);
+      size_t colon = rest.find(": ", at);
+      if (at != std::string_view::npos && colon != std::string_view::npos) {
+        size_t digits = at + AT_LINE.size();
+        std::string_view number = rest.substr(digits, colon - digits);
+        std::from_chars(number.data(), number.data() + number.size(),
+                        violation.line);
+        violation.file =
+            std::filesystem::path(rest.substr(0, at)).lexically_normal();
+        violation.message = rest.substr(colon + 2);
+      }
+    }
+    bool repeated = false;
+    for (const auto &seen : violations) {
+      if (seen.file == violation.file && seen.line == violation.line &&
+          seen.message == violation.message)
+        repeated = true;
+    }
+    if (!repeated)
+      violations.push_back(std::move(violation));
+  }
+  return violations;
+}
+
+} // namespace hyprquery
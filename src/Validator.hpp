@@ -0,0 +1,38 @@
+#pragma once
+
+#include "ConfigUtils.hpp"
+#include "Schema.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery {
+
+// One way a config disagrees with its schema
+struct Violation {
+  std::string file;
+  // 1-based, 0 when unknown
+  size_t line = 0;
+  // Empty for a parse error that names no key
+  std::string key;
+  // "type", "range", "choice" or "parse"
+  std::string kind;
+  std::string message;
+  Value value;
+};
+
+// Check a value the config assigns against the schema option of its key:
+// booleans are 0 or 1, numbers and vector components stay within min and
+// max, choices are a valid index, colors and gradients decode. Types
+// hyprlang parses itself fail as parse errors instead.
+std::optional<Violation> checkValue(const Schema &schema,
+                                    const SchemaOption &option,
+                                    const QueryResult &result);
+
+// One violation per error in a parse error hyprlang collected with
+// throwAllErrors, at the innermost file and line it names
+std::vector<Violation> parseErrorViolations(std::string_view error,
+                                            const std::string &configPath);
+
+} // namespace hyprquery
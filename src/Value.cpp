@@ -0,0 +1,110 @@
+#include "Value.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+namespace hyprquery {
+
+namespace {
+
+template <typename T> char *format(char *first, char *last, T value) {
+  return std::to_chars(first, last, value).ptr;
+}
+
+char *append(char *out, std::string_view text) {
+  return std::copy(text.begin(), text.end(), out);
+}
+
+// {"angle":45.0,"stops":["#rrggbbaa",...]}, as the JSON exporter writes it
+char *formatGradient(char *first, char *last, const Gradient &gradient) {
+  char *out = append(first, "{\"angle\":");
+  if (std::isfinite(gradient.angle)) {
+    char *number = out;
+    out = format(out, last, gradient.angle);
+    if (std::string_view(number, out - number).find_first_of(".e") ==
+        std::string_view::npos)
+      out = append(out, ".0");
+  } else {
+    out = append(out, "null");
+  }
+  out = append(out, ",\"stops\":[");
+  for (size_t i = 0; i < gradient.count; ++i) {
+    if (i > 0)
+      *out++ = ',';
+    *out++ = '"';
+    out = formatColor(out, gradient.stops[i], ColorFormat::HexAlpha);
+    *out++ = '"';
+  }
+  return append(out, "]}");
+}
+
+} // namespace
+
+ValueText::ValueText(const Value &value) {
+  char *first = m_buffer;
+  char *last = m_buffer + sizeof(m_buffer);
+  if (auto *text = std::get_if<std::string>(&value)) {
+    m_view = *text;
+  } else if (auto *number = std::get_if<int64_t>(&value)) {
+    m_view = {first, format(first, last, *number)};
+  } else if (auto *number = std::get_if<double>(&value)) {
+    m_view = {first, format(first, last, *number)};
+  } else if (auto *vec = std::get_if<Vec2>(&value)) {
+    char *end = format(first, last, vec->x);
+    *end++ = ',';
+    *end++ = ' ';
+    m_view = {first, format(end, last, vec->y)};
+  } else if (auto *gradient = std::get_if<Gradient>(&value)) {
+    m_view = {first, formatGradient(first, last, *gradient)};
+  } else if (auto *list = std::get_if<KeywordList>(&value)) {
+    for (size_t i = 0; i < list->entries.size(); ++i) {
+      if (i > 0)
+        m_joined += '\n';
+      m_joined += list->store->value(list->entries[i]);
+    }
+    m_view = m_joined;
+  }
+}
+
+std::string formatValue(const Value &value) {
+  return std::string(ValueText(value).view());
+}
+
+nlohmann::json toJson(const Value &value) {
+  auto number = [](double x) {
+    return std::isfinite(x) ? nlohmann::json(x) : nlohmann::json();
+  };
+  if (auto *text = std::get_if<std::string>(&value))
+    return *text;
+  if (auto *integer = std::get_if<int64_t>(&value))
+    return *integer;
+  if (auto *real = std::get_if<double>(&value))
+    return number(*real);
+  if (auto *vec = std::get_if<Vec2>(&value))
+    return nlohmann::json::array({number(vec->x), number(vec->y)});
+  if (auto *gradient = std::get_if<Gradient>(&value)) {
+    nlohmann::json stops = nlohmann::json::array();
+    for (size_t i = 0; i < gradient->count; ++i) {
+      char text[16];
+      char *end =
+          formatColor(text, gradient->stops[i], ColorFormat::HexAlpha);
+      stops.push_back(std::string(text, end));
+    }
+    return {{"angle", number(gradient->angle)}, {"stops", stops}};
+  }
+  if (auto *list = std::get_if<KeywordList>(&value)) {
+    nlohmann::json entries = nlohmann::json::array();
+    for (uint32_t entry : list->entries) {
+      const KeywordStore &store = *list->store;
+      entries.push_back({{"file", store.file(entry)},
+                         {"keyword", store.command(entry)},
+                         {"line", store.line(entry)},
+                         {"value", store.value(entry)}});
+    }
+    return entries;
+  }
+  return nullptr;
+}
+
+} // namespace hyprquery
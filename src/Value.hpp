@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Color.hpp"
+#include "KeywordStore.hpp"
+#include <cstdint>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace hyprquery {
+
+struct Vec2 {
+  double x = 0;
+  double y = 0;
+
+  bool operator==(const Vec2 &) const = default;
+};
+
+// A queried value in its native type, std::monostate for NULL. CUSTOM
+// values are kept as their text; a Gradient is a color decoded for a
+// `key|json` query and a KeywordList the entries of a keyword query.
+using Value = std::variant<std::monostate, int64_t, double, Vec2,
+                           std::string, Gradient, KeywordList>;
+
+// A value as hyq prints it: numbers in their shortest round-trip form,
+// VEC2 as "x, y", a Gradient as compact JSON, a list as its values one per
+// line and NULL as nothing. Numbers are formatted into an inline buffer;
+// strings are viewed in place, so the value has to outlive this.
+class ValueText {
+public:
+  explicit ValueText(const Value &value);
+
+  ValueText(const ValueText &) = delete;
+  ValueText &operator=(const ValueText &) = delete;
+
+  std::string_view view() const { return m_view; }
+  operator std::string_view() const { return m_view; }
+
+private:
+  // Fits a Gradient with all of its stops
+  char m_buffer[192];
+  // A list joined into one text
+  std::string m_joined;
+  std::string_view m_view;
+};
+
+std::string formatValue(const Value &value);
+
+// Numbers as JSON numbers, VEC2 as [x, y], a Gradient as an object of
+// angle and stops, a list as an array of file, keyword, line and value
+// objects, NULL as null
+nlohmann::json toJson(const Value &value);
+
+} // namespace hyprquery
@@ -0,0 +1,142 @@
+#include "WatchMode.hpp"
+#include "FileWatcher.hpp"
+#include "InputFiles.hpp"
+#include "Io.hpp"
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <poll.h>
+#include <spdlog/spdlog.h>
+#include <string_view>
+#include <utility>
+
+namespace hyprquery {
+
+namespace {
+
+constexpr int DEBOUNCE_MS = 100;
+
+// By query position and result key, so that one key asked with different
+// filters or formats, or matched by several patterns, is tracked once per
+// query
+using ValueKey = std::pair<size_t, std::string>;
+using ValueMap = std::map<ValueKey, QueryResult>;
+
+std::unique_ptr<QueryEngine> build(const EngineOptions &options,
+                                   const std::vector<QueryInput> &queries) {
+  InputFiles::Scope inputs;
+  auto engine = std::make_unique<QueryEngine>(options);
+  engine->prepareConfig(queries);
+  engine->parse();
+  if (!engine->parseError().empty())
+    spdlog::debug("[watch] Parse error: {}", engine->parseError());
+  return engine;
+}
+
+ValueMap evaluate(const QueryEngine &engine,
+                  const std::vector<QueryInput> &queries) {
+  ValueMap values;
+  for (const auto &query : queries) {
+    for (auto &result : engine.executeQueries({query}))
+      values.emplace(ValueKey{query.index, result.key}, std::move(result));
+  }
+  return values;
+}
+
+nlohmann::json valueJson(const QueryResult &result) {
+  return {{"val", toJson(result.value)}, {"type", result.type}};
+}
+
+void appendRecord(std::string &output, size_t query,
+                  const QueryResult &current, const QueryResult *previous) {
+  nlohmann::json record;
+  record["key"] = current.key;
+  record["query"] = query;
+  record["val"] = toJson(current.value);
+  record["type"] = current.type;
+  record["flags"] = current.flags;
+  record["prev"] = previous ? valueJson(*previous) : nlohmann::json();
+  output += record.dump();
+  output += '\n';
+}
+
+// Records for every key whose value or type differs; keys a wildcard no
+// longer matches are reported as NULL
+std::string diff(const ValueMap &before, const ValueMap &after) {
+  std::string output;
+  for (const auto &[key, current] : after) {
+    auto it = before.find(key);
+    if (it == before.end())
+      appendRecord(output, key.first, current, nullptr);
+    else if (it->second.value != current.value ||
+             it->second.type != current.type)
+      appendRecord(output, key.first, current, &it->second);
+  }
+  for (const auto &[key, previous] : before) {
+    if (after.contains(key))
+      continue;
+    QueryResult gone{key.second, {}, "NULL", {}, {}};
+    appendRecord(output, key.first, gone, &previous);
+  }
+  return output;
+}
+
+} // namespace
+
+int runWatch(EngineOptions options, const std::vector<QueryInput> &queries,
+             int outputFd) {
+  FileWatcher watcher;
+  if (!watcher.isValid())
+    return 1;
+  options.trackDependencies = true;
+  options.incremental = true;
+
+  catchStopSignals();
+
+  auto engine = build(options, queries);
+  watcher.watch(engine->dependencies());
+  ValueMap values = evaluate(*engine, queries);
+  if (!writeAll(outputFd, diff({}, values)))
+    return 1;
+
+  bool changePending = false;
+  while (!stopRequested()) {
+    // Block without a timeout while idle; only a pending change arms the
+    // debounce timer
+    pollfd fds[2] = {{watcher.fd(), POLLIN, 0}, {outputFd, 0, 0}};
+    int ready = poll(fds, 2, changePending ? DEBOUNCE_MS : -1);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      spdlog::error("poll failed: {}", strerror(errno));
+      return 1;
+    }
+    if (fds[1].revents & (POLLERR | POLLHUP)) {
+      spdlog::debug("[watch] Output closed");
+      break;
+    }
+    if (ready == 0 && changePending) {
+      changePending = false;
+      // Changed leaves are parsed again in place when that is exact
+      if (!engine->reparseChanged()) {
+        spdlog::debug("[watch] Reparsing {}", options.configPath);
+        engine = build(options, queries);
+        watcher.watch(engine->dependencies());
+      }
+      ValueMap next = evaluate(*engine, queries);
+      std::string records = diff(values, next);
+      values = std::move(next);
+      if (!writeAll(outputFd, records))
+        return 1;
+      continue;
+    }
+    if (fds[0].revents & POLLIN)
+      changePending = watcher.readEvents() || changePending;
+  }
+  spdlog::debug("[watch] Stopped");
+  return 0;
+}
+
+} // namespace hyprquery
@@ -0,0 +1,10 @@
+#pragma once
+#include "QueryEngine.hpp"
+
+namespace hyprquery {
+// Answer the queries once, then reparse after every debounced change to
+// the config's source graph and write one NDJSON record per value that
+// changed. Runs until SIGINT, SIGTERM or a closed output.
+int runWatch(EngineOptions options, const std::vector<QueryInput> &queries,
+             int outputFd);
+} // namespace hyprquery
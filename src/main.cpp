@@ -1,241 +1,412 @@
+#include "BatchMode.hpp"
 #include "ConfigUtils.hpp"
-#include "ExportEnv.hpp"
-#include "ExportJson.hpp"
+#include "Daemon.hpp"
+#include "Output.hpp"
+#include "PathCache.hpp"
+#include "Profiler.hpp"
+#include "QueryEngine.hpp"
+#include "QueryRunner.hpp"
+#include "Schema.hpp"
 #include "SourceHandler.hpp"
+#include "WatchMode.hpp"
 #include <CLI/CLI.hpp>
+#include <algorithm>
 #include <filesystem>
-#include <functional>
+#include <fstream>
 #include <hyprlang.hpp>
-#include <nlohmann/json.hpp>
-#include <regex>
+#include <iostream>
+#include <iterator>
+#include <optional>
 #include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <unistd.h>
 
-using hyprquery::exportEnv;
-using hyprquery::exportJson;
-
-static Hyprlang::CConfig *pConfig = nullptr;
-
-void prepareConfig(const std::vector<hyprquery::QueryInput> &queries,
-                   std::string &configFilePath,
-                   Hyprlang::SConfigOptions &options,
-                   std::vector<std::string> &dynamicVars, bool debugLogging) {
-  std::hash<std::string> hasher;
-  bool variableSearch = false;
-  for (const auto &q : queries) {
-    if (q.isDynamicVariable) {
-      variableSearch = true;
-      break;
-    }
+int compileSchema(const std::string &inputPath, const std::string &outputPath) {
+  std::string error;
+  auto schema = hyprquery::Schema::load(inputPath, error);
+  if (!schema) {
+    std::cerr << "Error: " << error << std::endl;
+    return 1;
   }
-  std::string configStream;
-  if (variableSearch) {
-    if (debugLogging)
-      spdlog::debug("[variable-search] Enabled");
-    std::ifstream src(configFilePath);
-    std::ostringstream dst;
-    dst << src.rdbuf();
-    for (size_t i = 0; i < queries.size(); ++i) {
-      if (queries[i].isDynamicVariable) {
-        std::string dynKey =
-            "Dynamic_" + std::to_string(hasher(queries[i].query));
-        std::string dynLine = "\n" + dynKey + "=" + queries[i].query + "\n";
-        dst << dynLine;
-        if (debugLogging)
-          spdlog::debug(std::string("[variable-search] Injecting line: ") +
-                        dynLine.substr(1, dynLine.size() - 2));
-      }
-    }
-    src.close();
-    configStream = dst.str();
-    configFilePath = configStream;
-    options.pathIsStream = true;
+  std::string compiled = schema->compile();
+  std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+  if (!out.write(compiled.data(), compiled.size())) {
+    std::cerr << "Error: Could not write compiled schema: " << outputPath
+              << std::endl;
+    return 1;
   }
-  dynamicVars.resize(queries.size());
+  spdlog::debug("[schema] Compiled {} options into {} bytes",
+                schema->options().size(), compiled.size());
+  return 0;
+}
 
-  pConfig = new Hyprlang::CConfig(configFilePath.c_str(), options);
-  for (size_t i = 0; i < queries.size(); ++i) {
-    if (queries[i].isDynamicVariable) {
-      std::string dynKey =
-          "Dynamic_" + std::to_string(hasher(queries[i].query));
-      dynamicVars[i] = dynKey;
-      pConfig->addConfigValue(dynKey.c_str(), (Hyprlang::STRING) "");
-      if (debugLogging)
-        spdlog::debug(std::string("[variable-search] Mapping query '") +
-                      queries[i].query + "' to injected key '" + dynKey + "'");
-    } else {
-      dynamicVars[i] = queries[i].query;
-      pConfig->addConfigValue(queries[i].query.c_str(), (Hyprlang::STRING) "");
-    }
+// Split NAME#value when NAME is one of the configs, by its path as given,
+// its file name or its stem; -1 when value applies to every config
+std::pair<int, std::string> scopeOf(const std::string &value,
+                                    const std::vector<std::string> &configs) {
+  size_t hash = value.find('#');
+  if (hash == std::string::npos)
+    return {-1, value};
+  std::string name = value.substr(0, hash);
+  for (size_t i = 0; i < configs.size(); ++i) {
+    std::filesystem::path path(configs[i]);
+    if (name == configs[i] || name == path.filename().string() ||
+        name == path.stem().string())
+      return {static_cast<int>(i), value.substr(hash + 1)};
   }
-  pConfig->commence();
+  return {-1, value};
 }
 
-std::vector<hyprquery::QueryResult>
-executeQueries(const std::vector<hyprquery::QueryInput> &queries,
-               const std::vector<std::string> &dynamicVars, bool debugLogging) {
-  std::vector<hyprquery::QueryResult> results;
-  for (size_t i = 0; i < queries.size(); ++i) {
-    hyprquery::QueryResult result;
-    result.key = queries[i].query;
-    std::string lookupKey =
-        queries[i].isDynamicVariable ? dynamicVars[i] : queries[i].query;
-    if (debugLogging)
-      spdlog::debug(std::string("[variable-search] Lookup key for query '") +
-                    queries[i].query + "' is '" + lookupKey + "'");
-    if (debugLogging && queries[i].isDynamicVariable) {
-      spdlog::debug(std::string("[variable-search] Query '") +
-                    queries[i].query + "' lookup key: '" + lookupKey + "'");
+// Directories stand for the *.conf files directly inside them, sorted
+std::vector<std::string> expandDirectories(
+    const std::vector<std::string> &paths) {
+  std::vector<std::string> files;
+  for (const auto &path : paths) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(path, ec)) {
+      files.push_back(path);
+      continue;
     }
-    std::any value = pConfig->getConfigValue(lookupKey.c_str());
-    result.value = hyprquery::ConfigUtils::convertValueToString(value);
-    result.type = hyprquery::ConfigUtils::getValueTypeName(value);
-    if (queries[i].isDynamicVariable && result.value == queries[i].query) {
-      result.value = "";
-      result.type = "NULL";
+    std::vector<std::string> inside;
+    for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
+      if (entry.is_regular_file(ec) && entry.path().extension() == ".conf")
+        inside.push_back(entry.path().string());
     }
-    if (!queries[i].expectedType.empty()) {
-      if (hyprquery::normalizeType(result.type) !=
-          hyprquery::normalizeType(queries[i].expectedType)) {
-        result.value = "";
-        result.type = "NULL";
-      }
-    }
-    if (!queries[i].expectedRegex.empty()) {
-      try {
-        std::regex rx(queries[i].expectedRegex);
-        if (!std::regex_match(result.value, rx)) {
-          result.value = "";
-          result.type = "NULL";
-        }
-      } catch (const std::regex_error &) {
-        result.value = "";
-        result.type = "NULL";
-      }
-    }
-    results.push_back(result);
+    std::sort(inside.begin(), inside.end());
+    files.insert(files.end(), inside.begin(), inside.end());
   }
-  return results;
+  return files;
 }
 
-void outputResults(const std::vector<hyprquery::QueryResult> &results,
-                   const std::string &exportFormat,
-                   const std::string &delimiter,
-                   const std::vector<hyprquery::QueryInput> &queries) {
-  if (exportFormat == "json") {
-    hyprquery::exportJson(results);
-  } else if (exportFormat == "env") {
-
-    std::vector<hyprquery::QueryInput> patchedQueries = queries;
-    for (auto &q : patchedQueries) {
-      if (!q.query.empty() && q.query[0] == '$') {
-        q.query = q.query.substr(1);
-      }
+// Resolve a config and its schema in place; the schema may be relative to
+// the config's directory
+bool resolvePaths(std::string &configFilePath, std::string &schemaFilePath) {
+  configFilePath = hyprquery::ConfigUtils::normalizePath(configFilePath);
+  auto resolvedPaths = hyprquery::SourceHandler::resolvePath(configFilePath);
+  if (resolvedPaths.empty()) {
+    std::cerr << "Error: Could not resolve configuration file path: "
+              << configFilePath << std::endl;
+    return false;
+  }
+  configFilePath = resolvedPaths.front().string();
+  if (!hyprquery::PathCache::status(configFilePath).exists) {
+    std::cerr << "Error: Configuration file does not exist: " << configFilePath
+              << std::endl;
+    return false;
+  }
+  if (!schemaFilePath.empty()) {
+    schemaFilePath = hyprquery::ConfigUtils::normalizePath(schemaFilePath);
+    auto resolvedSchemaPath = hyprquery::SourceHandler::resolvePath(
+        schemaFilePath,
+        std::filesystem::path(configFilePath).parent_path().string());
+    if (!resolvedSchemaPath.empty()) {
+      schemaFilePath = resolvedSchemaPath.front().string();
     }
-    hyprquery::exportEnv(results, patchedQueries);
-  } else {
-    for (size_t i = 0; i < results.size(); ++i) {
-      std::cout << (results[i].type == "NULL" ? "" : results[i].value);
-      if (i + 1 < results.size())
-        std::cout << delimiter;
+    if (!hyprquery::PathCache::status(schemaFilePath).exists) {
+      std::cerr << "Error: Schema file does not exist: " << schemaFilePath
+                << std::endl;
+      return false;
     }
-    std::cout << std::endl;
   }
+  return true;
 }
 
+// Writes the --profile summary and trace once main() returns
+struct ProfileReport {
+  bool summary = false;
+  std::string tracePath;
+
+  ~ProfileReport() {
+    if (summary)
+      hyprquery::Profiler::writeSummary(std::cerr);
+    if (!tracePath.empty() && !hyprquery::Profiler::writeTrace(tracePath))
+      std::cerr << "Error: Could not write profile trace: " << tracePath
+                << std::endl;
+  }
+};
+
 int main(int argc, char **argv) {
   CLI::App app{"hyprquery - A configuration parser for hypr* config files"};
   std::vector<std::string> rawQueries;
-  std::string configFilePath;
-  std::string schemaFilePath;
+  std::vector<std::string> configFilePaths;
+  std::vector<std::string> schemaFilePaths;
   bool allowMissing = false;
   bool getDefaultKeys = false;
   bool strictMode = false;
   bool followSource = false;
   bool debugLogging = false;
+  bool useCache = false;
+  bool daemonMode = false;
+  bool connectMode = false;
+  bool batchMode = false;
+  bool watchMode = false;
+  bool builtinSchema = false;
+  bool lazySchema = false;
+  bool compact = false;
+  bool dumpAll = false;
+  bool skipDefaults = false;
+  bool validate = false;
+  bool noFastPath = false;
+  std::vector<std::string> keywords = hyprquery::defaultKeywords();
+  std::vector<std::string> compileSchemaPaths;
+  size_t prefetchThreads = 4;
+  ProfileReport profile;
   std::string delimiter = "\n";
   std::string exportFormat;
-  app.add_option(
-         "--query,-Q", rawQueries,
-         "Query to execute (format: query[expectedType][expectedRegex], can be "
-         "specified multiple times)")
-      ->required()
-      ->take_all();
-  app.add_option("config_file", configFilePath, "Configuration file")
-      ->required();
-  app.add_option("--schema", schemaFilePath, "Schema file");
+  auto *queryOption =
+      app.add_option(
+             "--query,-Q", rawQueries,
+             "Query to execute (format: query[expectedType][expectedRegex], "
+             "can be specified multiple times)")
+          ->take_all();
+  app.add_option("config_file", configFilePaths,
+                 "Configuration files, parsed in parallel when there are "
+                 "several");
+  auto *schemaOption =
+      app.add_option("--schema", schemaFilePaths,
+                     "Schema file, JSON or compiled with --compile-schema; "
+                     "NAME#PATH applies it to one config only")
+          ->allow_extra_args(false);
+  app.add_flag("--builtin-schema", builtinSchema,
+               "Use the Hyprland schema built into hyq")
+      ->excludes(schemaOption);
   app.add_flag("--allow-missing", allowMissing, "Allow missing values");
   app.add_flag("--get-defaults", getDefaultKeys, "Get default keys");
-  app.add_flag("--strict", strictMode, "Enable strict mode");
-  app.add_option("--export", exportFormat, "Export format: json or env");
+  auto *strictOption =
+      app.add_flag("--strict", strictMode, "Enable strict mode");
+  app.add_flag("--lazy-schema", lazySchema,
+               "Register only the schema options that are queried")
+      ->excludes(strictOption);
+  app.add_option("--export", exportFormat,
+                 "Export format: json, ndjson or env");
+  app.add_flag("--compact", compact, "Write --export json on a single line");
   app.add_flag("--source,-s", followSource, "Follow the source command");
   app.add_flag("--debug", debugLogging, "Enable debug logging");
+  app.add_option("--prefetch-threads", prefetchThreads,
+                 "Threads reading sourced files ahead of the parser, 0 "
+                 "disables (default: 4)");
+  app.add_flag("--cache", useCache,
+               "Reuse a snapshot of the parsed config while its source "
+               "files are unchanged");
+  auto *daemonOption =
+      app.add_flag("--daemon", daemonMode,
+                   "Keep the parsed config resident and serve queries on a "
+                   "Unix socket");
+  auto *connectOption = app.add_flag(
+      "--connect", connectMode,
+      "Ask a running daemon first, parse in-process if there is none");
+  auto *batchOption =
+      app.add_flag("--batch", batchMode,
+                   "Read queries from stdin, one per line, and answer each "
+                   "with an NDJSON record");
+  auto *watchOption =
+      app.add_flag("--watch", watchMode,
+                   "Reparse whenever a file of the source graph changes and "
+                   "write an NDJSON record per changed value")
+          ->excludes(daemonOption)
+          ->excludes(connectOption)
+          ->excludes(batchOption);
+  auto *dumpAllOption =
+      app.add_flag("--dump-all", dumpAll,
+                   "Output every schema key, assigned key and variable")
+          ->excludes(daemonOption)
+          ->excludes(connectOption)
+          ->excludes(batchOption)
+          ->excludes(watchOption);
+  app.add_flag("--skip-defaults", skipDefaults,
+               "Leave schema defaults the config never sets out of "
+               "--dump-all")
+      ->needs(dumpAllOption);
+  app.add_flag("--validate", validate,
+               "Check every assigned value against the schema and report "
+               "violations; directories validate each *.conf inside")
+      ->excludes(queryOption)
+      ->excludes(daemonOption)
+      ->excludes(connectOption)
+      ->excludes(batchOption)
+      ->excludes(watchOption)
+      ->excludes(dumpAllOption);
+  app.add_flag("--no-fast-path", noFastPath,
+               "Always parse with hyprlang, even for plain queries the raw "
+               "scanner could answer");
+  app.add_option("--keywords", keywords,
+                 "Repeated keywords to capture as lists, NAME* also with "
+                 "flags; empty captures none (default: bind*,exec,"
+                 "exec-once,exec-shutdown,windowrule,windowrulev2,"
+                 "layerrule,workspace,monitor,env)")
+      ->delimiter(',');
+  app.add_option("--compile-schema", compileSchemaPaths,
+                 "Compile a JSON schema into the binary format: IN OUT")
+      ->expected(2);
+  app.add_flag("--profile", profile.summary,
+               "Print phase timings and counters to stderr");
+  app.add_option("--profile-trace", profile.tracePath,
+                 "Write phase and per-file parse spans as Chrome trace JSON");
   app.add_option("--delimiter,-D", delimiter,
                  "Delimiter for plain output (default: newline)");
   CLI11_PARSE(app, argc, argv);
-  configFilePath = hyprquery::ConfigUtils::normalizePath(configFilePath);
-  auto resolvedPaths = hyprquery::SourceHandler::resolvePath(configFilePath);
-  if (resolvedPaths.empty()) {
-    std::cerr << "Error: Could not resolve configuration file path: "
-              << configFilePath << std::endl;
-    return 1;
+  if (profile.summary || !profile.tracePath.empty())
+    hyprquery::Profiler::enable();
+  hyprquery::ProfileSpan total("hyq");
+  if (debugLogging) {
+    spdlog::set_level(spdlog::level::debug);
+    spdlog::flush_on(spdlog::level::debug);
+  } else {
+    spdlog::set_level(spdlog::level::off);
   }
-  configFilePath = resolvedPaths.front().string();
-  if (!std::filesystem::exists(configFilePath)) {
-    std::cerr << "Error: Configuration file does not exist: " << configFilePath
-              << std::endl;
-    return 1;
+  std::erase(keywords, "");
+  if (compileSchemaPaths.size() == 2)
+    return compileSchema(compileSchemaPaths[0], compileSchemaPaths[1]);
+  if (configFilePaths.empty()) {
+    std::cerr << "config_file is required" << std::endl;
+    return 106;
   }
-  hyprquery::SourceHandler::setConfigDir(
-      std::filesystem::path(configFilePath).parent_path().string());
-  if (!schemaFilePath.empty()) {
-    schemaFilePath = hyprquery::ConfigUtils::normalizePath(schemaFilePath);
-    auto resolvedSchemaPath =
-        hyprquery::SourceHandler::resolvePath(schemaFilePath);
-    if (!resolvedSchemaPath.empty()) {
-      schemaFilePath = resolvedSchemaPath.front().string();
-    }
-    if (!std::filesystem::exists(schemaFilePath)) {
-      std::cerr << "Error: Schema file does not exist: " << schemaFilePath
+  if (validate) {
+    if (schemaFilePaths.empty() && !builtinSchema) {
+      std::cerr << "--validate needs --schema or --builtin-schema"
                 << std::endl;
+      return 106;
+    }
+    if (exportFormat == "env") {
+      std::cerr << "--validate writes plain, json or ndjson" << std::endl;
+      return 106;
+    }
+    configFilePaths = expandDirectories(configFilePaths);
+    if (configFilePaths.empty()) {
+      std::cerr << "Error: No config files to validate" << std::endl;
       return 1;
     }
   }
-  Hyprlang::SConfigOptions options;
-  options = {.verifyOnly = static_cast<bool>(getDefaultKeys ? 1 : 0),
-             .allowMissingConfig = static_cast<bool>(1)};
-  std::vector<hyprquery::QueryInput> queries =
-      hyprquery::parseQueryInputs(rawQueries);
-  std::vector<std::string> dynamicVars;
-  prepareConfig(queries, configFilePath, options, dynamicVars, debugLogging);
-  if (!schemaFilePath.empty()) {
-    hyprquery::ConfigUtils::addConfigValuesFromSchema(*pConfig, schemaFilePath);
+  const size_t configCount = configFilePaths.size();
+  if (configCount > 1 &&
+      (daemonMode || connectMode || batchMode || watchMode)) {
+    std::cerr << "--daemon, --connect, --batch and --watch take a single "
+                 "config_file"
+              << std::endl;
+    return 106;
   }
-  if (followSource) {
-    if (debugLogging)
-      spdlog::debug("Registering source handler");
-    hyprquery::SourceHandler::registerHandler(pConfig);
+
+  // Queries and schemas apply to every config unless scoped to one
+  std::vector<std::vector<std::string>> jobQueries(configCount);
+  for (const auto &raw : rawQueries) {
+    auto [index, query] = scopeOf(raw, configFilePaths);
+    for (size_t i = 0; i < configCount; ++i) {
+      if (index < 0 || static_cast<size_t>(index) == i)
+        jobQueries[i].push_back(query);
+    }
   }
-  if (debugLogging) {
-    spdlog::set_level(spdlog::level::debug);
-    spdlog::flush_on(spdlog::level::debug);
-  } else {
-    spdlog::set_level(spdlog::level::off);
+  std::vector<std::string> jobSchemas(configCount);
+  std::vector<bool> scopedSchema(configCount, false);
+  for (const auto &raw : schemaFilePaths) {
+    auto [index, schema] = scopeOf(raw, configFilePaths);
+    for (size_t i = 0; i < configCount; ++i) {
+      if (index < 0 ? !scopedSchema[i] : static_cast<size_t>(index) == i)
+        jobSchemas[i] = schema;
+    }
+    if (index >= 0)
+      scopedSchema[index] = true;
   }
-  const auto PARSERESULT = pConfig->parse();
-  if (PARSERESULT.error) {
-    if (debugLogging)
-      spdlog::debug(std::string("Parse error: ") + PARSERESULT.getError());
-    if (strictMode) {
+  for (size_t i = 0; i < configCount; ++i) {
+    if (jobQueries[i].empty() && !daemonMode && !batchMode && !dumpAll &&
+        !validate) {
+      std::cerr << "--query is required"
+                << (configCount > 1 ? " for " + configFilePaths[i] : "")
+                << std::endl;
+      return 106;
+    }
+  }
+  std::vector<hyprquery::ConfigJob> jobs(configCount);
+  try {
+    for (size_t i = 0; i < configCount; ++i)
+      jobs[i].queries = hyprquery::parseQueryInputs(jobQueries[i]);
+  } catch (const std::invalid_argument &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 106;
+  }
+
+  hyprquery::ProfileSpan resolveSpan("resolve paths");
+  // Only while resolving, the daemon and --watch outlive any file state
+  std::optional<hyprquery::PathCache::Scope> paths(std::in_place);
+  for (size_t i = 0; i < configCount; ++i) {
+    auto &options = jobs[i].options;
+    options.configPath = configFilePaths[i];
+    options.schemaPath = jobSchemas[i];
+    if (!resolvePaths(options.configPath, options.schemaPath))
       return 1;
+    options.builtinSchema = builtinSchema;
+    options.lazySchema = lazySchema;
+    options.prefetchWorkers = prefetchThreads;
+    options.followSource = followSource;
+    options.getDefaults = getDefaultKeys;
+    options.dumpAll = dumpAll;
+    options.validate = validate;
+    options.fastPath = !noFastPath;
+    options.keywords = keywords;
+    options.debugLogging = debugLogging;
+    jobs[i].label = configFilePaths[i];
+    jobs[i].includeDefaults = !skipDefaults;
+  }
+  paths.reset();
+  resolveSpan.finish();
+  const hyprquery::EngineOptions &engineOptions = jobs.front().options;
+
+  if (daemonMode) {
+    hyprquery::Daemon daemon(
+        engineOptions, hyprquery::Daemon::defaultSocketPath(engineOptions));
+    return daemon.run();
+  }
+  if (batchMode)
+    return hyprquery::runBatch(engineOptions, strictMode, STDIN_FILENO,
+                               STDOUT_FILENO);
+  if (connectMode) {
+    std::string socketPath =
+        hyprquery::Daemon::defaultSocketPath(engineOptions);
+    auto exitCode = hyprquery::Daemon::query(
+        socketPath,
+        {jobQueries.front(), exportFormat, delimiter, strictMode, compact});
+    if (exitCode)
+      return *exitCode;
+    spdlog::debug("[connect] No daemon on {}, parsing in-process", socketPath);
+  }
+
+  if (watchMode)
+    return hyprquery::runWatch(engineOptions, jobs.front().queries,
+                               STDOUT_FILENO);
+
+  // Several configs are parsed at the same time, each on its own thread
+  auto outcomes = hyprquery::runJobs(jobs, useCache);
+  if (validate) {
+    std::vector<hyprquery::Violation> violations;
+    for (auto &outcome : outcomes)
+      std::move(outcome.violations.begin(), outcome.violations.end(),
+                std::back_inserter(violations));
+    hyprquery::ProfileSpan outputSpan("export");
+    hyprquery::OutputWriter out(STDOUT_FILENO);
+    hyprquery::outputViolations(out, violations, exportFormat, compact);
+    out.flush();
+    return violations.empty() ? 0 : 1;
+  }
+  std::vector<hyprquery::QueryResult> results;
+  bool parseFailed = false;
+  for (auto &outcome : outcomes) {
+    if (!outcome.parseError.empty()) {
+      if (debugLogging)
+        spdlog::debug(std::string("Parse error: ") + outcome.parseError);
+      parseFailed = true;
     }
+    std::move(outcome.results.begin(), outcome.results.end(),
+              std::back_inserter(results));
   }
-  std::vector<hyprquery::QueryResult> results =
-      executeQueries(queries, dynamicVars, debugLogging);
+  if (parseFailed && strictMode)
+    return 1;
   int nullCount = 0;
   for (const auto &r : results) {
     if (r.type == "NULL")
       nullCount++;
   }
-  outputResults(results, exportFormat, delimiter, queries);
+  hyprquery::ProfileSpan outputSpan("export");
+  hyprquery::OutputWriter out(STDOUT_FILENO);
+  hyprquery::outputResults(out, results, exportFormat, delimiter, compact);
+  out.flush();
   return nullCount > 0 ? 1 : 0;
 }
@@ -0,0 +1,98 @@
+// A --cache run has to report the same results and parse error as the
+// same call without it, whichever query sets were cached before
+#include "Profiler.hpp"
+#include "QueryRunner.hpp"
+#include "TestUtil.hpp"
+#include <cstdlib>
+
+using namespace hyprquery;
+using namespace hyprquery::test;
+
+namespace {
+
+ConfigJob jobFor(const std::string &config,
+                 const std::vector<std::string> &queries) {
+  ConfigJob job;
+  job.label = config;
+  job.options.configPath = config;
+  // The raw scanner answers before the cache is looked at
+  job.options.fastPath = false;
+  job.queries = parseQueryInputs(queries);
+  return job;
+}
+
+// Every query set below has a plain key, which a parse registers and a
+// snapshot answers without
+uint64_t keysRegistered() {
+  return Profiler::counter(ProfileCounter::KeysRegistered);
+}
+
+// Whether the first cached run was a hit; the second one always has to be
+bool checkSame(const std::string &config,
+               const std::vector<std::string> &queries) {
+  ConfigOutcome cold = runJob(jobFor(config, queries), false);
+  bool firstHit = false;
+  for (int run = 0; run < 2; ++run) {
+    uint64_t before = keysRegistered();
+    ConfigOutcome cached = runJob(jobFor(config, queries), true);
+    bool hit = keysRegistered() == before;
+    if (run == 0)
+      firstHit = hit;
+    else
+      CHECK(hit);
+    CHECK_EQ(describe(cached.results), describe(cold.results));
+    CHECK_EQ(cached.parseError, cold.parseError);
+  }
+  return firstHit;
+}
+
+size_t snapshotCount(const std::string &cacheHome) {
+  size_t count = 0;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(cacheHome + "/hyprquery")) {
+    if (entry.path().extension() == ".hqc")
+      ++count;
+  }
+  return count;
+}
+
+} // namespace
+
+int main() {
+  // Counts the parses that a hit skips
+  Profiler::enable();
+  TempDir dir;
+  setenv("XDG_CACHE_HOME", (dir.path() + "/cache").c_str(), 1);
+  std::string config = dir.write("hyprland.conf", R"(general {
+  border_size = 2
+  gaps_in = 5
+}
+decoration {
+  rounding = 4
+}
+$accent = rgba(ca9ee6ff)
+)");
+
+  // Unqueried keys are unknown-key errors, so each query set has a parse
+  // error of its own; a wider set cached first must not hide them
+  CHECK(!checkSame(config, {"general:border_size", "decoration:rounding",
+                            "general:gaps_in"}));
+  CHECK(!checkSame(config, {"general:border_size"}));
+  CHECK(!checkSame(config, {"general:border_size", "decoration:rounding"}));
+  CHECK(!checkSame(config, {"general:border_size[INT][^2$]", "$accent"}));
+  CHECK(checkSame(config, {"general:border_size"}));
+  CHECK(!runJob(jobFor(config, {"general:border_size"}), false)
+             .parseError.empty());
+  CHECK(runJob(jobFor(config, {"general:border_size", "decoration:rounding",
+                               "general:gaps_in"}),
+               false)
+            .parseError.empty());
+  CHECK_EQ(snapshotCount(dir.path() + "/cache"), size_t(4));
+
+  // A changed config is a miss, and the new snapshot matches a cold run
+  dir.write("hyprland.conf", "general {\n  border_size = 3\n}\n");
+  CHECK(!checkSame(config, {"general:border_size"}));
+  CHECK(!checkSame(config, {"general:border_size", "decoration:rounding"}));
+
+  return finish("cache");
+}
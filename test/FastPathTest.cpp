@@ -0,0 +1,133 @@
+// FastPath answers from the raw text of a config, and has to answer every
+// query exactly like the full parse or give up. Only whether the parse
+// failed is compared, not hyprlang's wording.
+#include "ConfigGenerator.hpp"
+#include "ConfigScanner.hpp"
+#include "FastPath.hpp"
+#include "TestUtil.hpp"
+#include <algorithm>
+
+using namespace hyprquery;
+using namespace hyprquery::test;
+
+namespace {
+
+// Whether FastPath answered; a mismatch with the full parse is a failure
+bool agrees(EngineOptions options, const std::vector<std::string> &keys) {
+  auto queries = parseQueryInputs(keys);
+  auto fast = FastPath::run(options, queries);
+  if (!fast)
+    return false;
+  options.fastPath = false;
+  QueryEngine engine(options);
+  engine.prepareConfig(queries);
+  engine.parse();
+  auto full = engine.executeQueries(queries);
+  if (describe(fast->results) != describe(full) ||
+      fast->parseError.empty() != engine.parseError().empty()) {
+    std::cerr << options.configPath << ": fast path gives\n"
+              << describe(fast->results) << "error '" << fast->parseError
+              << "'\nbut the parse gives\n"
+              << describe(full) << "error '" << engine.parseError() << "'"
+              << std::endl;
+    ++g_failures;
+  }
+  return true;
+}
+
+// Every key and variable of a config alone and all at once; returns how
+// many FastPath answered alone
+size_t checkFixture(const std::string &path) {
+  std::vector<std::string> variables;
+  auto keys = ConfigScanner::collectKeys(path, false, &variables);
+  keys.insert(keys.end(), variables.begin(), variables.end());
+  keys.push_back("hyq_test:never_assigned");
+  EngineOptions options;
+  options.configPath = path;
+  size_t answered = 0;
+  for (const auto &key : keys)
+    answered += agrees(options, {key});
+  agrees(options, keys);
+  std::cout << path << ": answered " << answered << " of " << keys.size()
+            << std::endl;
+  return answered;
+}
+
+struct Case {
+  const char *name;
+  const char *text;
+  const char *query;
+  bool followSource;
+  // Whether FastPath may answer, or has to leave it to the parse
+  bool answers;
+};
+
+const Case CASES[] = {
+    {"category", "general {\n  gaps_in = 2\n  border_size = 1\n}\n",
+     "general:gaps_in", false, true},
+    {"nested category", "decoration {\n  blur {\n    size = 8\n  }\n}\n",
+     "decoration:blur:size", false, true},
+    {"a:b:c key", "decoration:blur:size = 4 # comment\n",
+     "decoration:blur:size", false, true},
+    {"last assignment", "misc:vfr = 1\nmisc:vfr = 0\n", "misc:vfr", false,
+     true},
+    {"variable", "$gap = 5\n", "$gap", false, true},
+    {"keyword line", "bind = SUPER, Q, exec, kitty\nmisc:vfr = 1\n",
+     "misc:vfr", false, true},
+    {"keyword query", "bind = SUPER, Q, exec, kitty\n", "bind", false, false},
+    {"unbalanced category", "general {\n  gaps_in = 2\n}\n}\n",
+     "general:gaps_in", false, false},
+    {"category on a key line", "general { gaps_in = 2\n}\n", "general:gaps_in",
+     false, false},
+    {"special category",
+     "device[mouse] {\n  sensitivity = 1\n}\nmisc:vfr = 1\n", "misc:vfr",
+     false, false},
+    {"expanded variable", "$gap = 5\ngeneral:gaps_in = $gap\n",
+     "general:gaps_in", false, false},
+    {"redefined variable", "$a = 1\n$b = $a\n$a = 2\n", "$b", false, false},
+    {"undefined variable", "$gap = 5\n", "$missing", false, false},
+    {"source= followed", "source = other.conf\nmisc:vfr = 1\n", "misc:vfr",
+     true, false},
+    {"directive", "# hyprlang noerror true\nmisc:vfr = 1\n", "misc:vfr",
+     false, false},
+};
+
+} // namespace
+
+int main() {
+  std::vector<std::string> fixtures;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(HYQ_TEST_CONFIG_DIR)) {
+    if (entry.path().extension() == ".conf")
+      fixtures.push_back(entry.path().string());
+  }
+  std::sort(fixtures.begin(), fixtures.end());
+  CHECK(!fixtures.empty());
+  for (const auto &path : fixtures)
+    checkFixture(path);
+
+  // The bench corpus: variables, values that expand them and nested
+  // categories, in one file FastPath reads without following source=
+  TempDir generated;
+  bench::GeneratorOptions generator;
+  generator.keys = 200;
+  generator.variables = 16;
+  generator.nesting = 3;
+  auto config = bench::generateConfig(generated.path() + "/tree", generator);
+  CHECK(checkFixture(config.mainPath) > 0);
+
+  TempDir dir;
+  dir.write("other.conf", "misc:vfr = 0\n");
+  for (const auto &test : CASES) {
+    EngineOptions options;
+    options.configPath = dir.write("case.conf", test.text);
+    options.followSource = test.followSource;
+    bool answered = agrees(options, {test.query});
+    if (answered != test.answers) {
+      std::cerr << test.name << ": fast path "
+                << (answered ? "answered" : "gave up") << std::endl;
+      ++g_failures;
+    }
+  }
+  return finish("fastpath");
+}
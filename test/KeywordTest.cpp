@@ -0,0 +1,74 @@
+// Keyword queries list every captured line with the file and line it came
+// from, across source= and past lines hyprlang skips.
+#include "QueryEngine.hpp"
+#include "TestUtil.hpp"
+
+using namespace hyprquery;
+using namespace hyprquery::test;
+
+namespace {
+
+nlohmann::json entry(const std::string &file, uint32_t line,
+                     std::string_view keyword, std::string_view value) {
+  return {{"file", file},
+          {"keyword", keyword},
+          {"line", line},
+          {"value", value}};
+}
+
+} // namespace
+
+int main() {
+  TempDir dir;
+  // The bind inside the false block is scanned but never reaches the
+  // handler, and $mod is expanded before it does
+  std::string main = dir.write("hyprland.conf",
+                               "$mod = SUPER\n"
+                               "bind = SUPER, Q, exec, kitty # terminal\n"
+                               "# hyprlang if HYQ_TEST_UNDEFINED\n"
+                               "bind = SUPER, X, exec, never\n"
+                               "bindel = , XF86AudioMute, exec, never\n"
+                               "# hyprlang endif\n"
+                               "source = binds.conf\n"
+                               "bind = $mod, E, exec, nautilus\n"
+                               "bindel = , XF86AudioRaiseVolume, exec, up\n"
+                               "bind = ALT, F, fullscreen\n");
+  std::string binds =
+      dir.write("binds.conf", "# media keys\n"
+                              "bindl = , XF86AudioPlay, exec, play\n"
+                              "bind = SUPER SHIFT, Q, killactive\n"
+                              "bindel = , XF86AudioLowerVolume, exec, down\n");
+
+  EngineOptions options;
+  options.configPath = main;
+  options.followSource = true;
+  const auto queries =
+      parseQueryInputs({"bind", "bindel", "bind[*][.*SUPER.*]"});
+  QueryEngine engine(options);
+  engine.prepareConfig(queries);
+  engine.parse();
+  CHECK_EQ(engine.parseError(), std::string());
+
+  auto results = engine.executeQueries(queries);
+  CHECK_EQ(results.size(), size_t(3));
+  if (results.size() != 3)
+    return finish("keyword");
+
+  const auto super = entry(main, 2, "bind", "SUPER, Q, exec, kitty");
+  const auto play = entry(binds, 2, "bindl", ", XF86AudioPlay, exec, play");
+  const auto kill = entry(binds, 3, "bind", "SUPER SHIFT, Q, killactive");
+  const auto down =
+      entry(binds, 4, "bindel", ", XF86AudioLowerVolume, exec, down");
+  const auto files = entry(main, 8, "bind", "SUPER, E, exec, nautilus");
+  const auto up = entry(main, 9, "bindel", ", XF86AudioRaiseVolume, exec, up");
+  const auto full = entry(main, 10, "bind", "ALT, F, fullscreen");
+
+  CHECK_EQ(toJson(results[0].value).dump(),
+           nlohmann::json::array({super, play, kill, down, files, up, full})
+               .dump());
+  CHECK_EQ(toJson(results[1].value).dump(),
+           nlohmann::json::array({down, up}).dump());
+  CHECK_EQ(toJson(results[2].value).dump(),
+           nlohmann::json::array({super, kill, files}).dump());
+  return finish("keyword");
+}
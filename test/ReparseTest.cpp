@@ -0,0 +1,228 @@
+// QueryEngine::reparseChanged() keeps the values of a parse and parses
+// only the changed files again. After every random edit of a config tree
+// its answers have to match a fresh engine's, and the edits it can not
+// make exact have to fall back to a full parse.
+#include "QueryEngine.hpp"
+#include "TestUtil.hpp"
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <random>
+#include <spdlog/fmt/fmt.h>
+
+using namespace hyprquery;
+using namespace hyprquery::test;
+
+namespace {
+
+constexpr unsigned SEED = 20251016;
+constexpr int STEPS = 300;
+
+// The content of every file of the tree, rendered from a few values
+struct Tree {
+  // main.conf, the root; never parsed in place
+  int base = 2;
+  int gaps = 5;
+  bool sourceBinds = true;
+  // conf.d/a.conf, defines $accent which b.conf expands
+  int rounding = 4;
+  int blurSize = 8;
+  uint32_t accent = 0xca9ee6;
+  bool dim = false;
+  // conf.d/b.conf
+  double sensitivity = 0.5;
+  bool vfrFromBase = false;
+  bool broken = false;
+  // binds.conf, keyword lines only
+  char bindKey = 'Q';
+
+  void write(const TempDir &dir) const {
+    dir.write("main.conf",
+              fmt::format("$base = {}\n"
+                          "source = ./conf.d/*.conf\n"
+                          "{}"
+                          "general {{\n"
+                          "  border_size = $base\n"
+                          "  gaps_in = {}\n"
+                          "}}\n",
+                          base, sourceBinds ? "source = ./binds.conf\n" : "",
+                          gaps));
+    dir.write("conf.d/a.conf",
+              fmt::format("decoration {{\n"
+                          "  rounding = {}\n"
+                          "  blur {{\n"
+                          "    size = {}\n"
+                          "  }}\n"
+                          "}}\n"
+                          "$accent = rgba({:06x}ff)\n"
+                          "{}",
+                          rounding, blurSize, accent,
+                          dim ? "decoration:dim_strength = 0.5\n" : ""));
+    dir.write("conf.d/b.conf",
+              fmt::format("input {{\n"
+                          "  sensitivity = {}\n"
+                          "}}\n"
+                          "general:col.active_border = $accent\n"
+                          "misc:vfr = {}\n"
+                          "{}",
+                          sensitivity, vfrFromBase ? "$base" : "1",
+                          broken ? "this line is not valid\n" : ""));
+    dir.write("binds.conf",
+              fmt::format("bind = SUPER, {}, exec, kitty\n"
+                          "bindel = , XF86AudioRaiseVolume, exec, up\n",
+                          bindKey));
+  }
+};
+
+enum class Edit {
+  Rounding,
+  BlurSize,
+  Sensitivity,
+  VfrFromBase,
+  // Expected to fall back to a full parse
+  Accent,
+  DimKey,
+  Binds,
+  SourceLine,
+  Base,
+  Gaps,
+  Broken,
+  Count
+};
+
+std::unique_ptr<QueryEngine> build(const EngineOptions &options,
+                                   const std::vector<QueryInput> &queries) {
+  auto engine = std::make_unique<QueryEngine>(options);
+  engine->prepareConfig(queries);
+  engine->parse();
+  return engine;
+}
+
+std::string answers(const QueryEngine &engine,
+                    const std::vector<QueryInput> &queries) {
+  return "error: " + engine.parseError() + "\n" +
+         describe(engine.executeQueries(queries)) + "dump:\n" +
+         describe(engine.dump(true));
+}
+
+} // namespace
+
+int main() {
+  TempDir dir;
+  Tree tree;
+  tree.write(dir);
+
+  EngineOptions options;
+  options.configPath = dir.path() + "/main.conf";
+  options.followSource = true;
+  options.trackDependencies = true;
+  options.incremental = true;
+  options.dumpAll = true;
+  const auto queries = parseQueryInputs(
+      {"general:border_size", "general:gaps_in", "decoration:rounding",
+       "decoration:blur:size", "decoration:dim_strength", "input:sensitivity",
+       "general:col.active_border", "misc:vfr", "$accent", "$base", "bind",
+       "bindel", "bind[*][.*SUPER.*]", "decoration:*"});
+
+  auto engine = build(options, queries);
+  CHECK_EQ(answers(*engine, queries), answers(*build(options, queries),
+                                              queries));
+
+  std::mt19937 random(SEED);
+  // A value in [low, high] other than current, so every edit changes a file
+  auto other = [&](int current, int low, int high) {
+    int value = std::uniform_int_distribution<int>(low, high - 1)(random);
+    return value >= current ? value + 1 : value;
+  };
+  size_t inPlace = 0, full = 0;
+  for (int step = 0; step < STEPS; ++step) {
+    auto edit = static_cast<Edit>(
+        std::uniform_int_distribution<int>(0, int(Edit::Count) - 1)(random));
+    // Whether the edit has to be parsed in place; leaves are only parsed
+    // in place while the whole tree parses cleanly
+    std::optional<bool> expectInPlace;
+    switch (edit) {
+    case Edit::Rounding:
+      tree.rounding = other(tree.rounding, 0, 20);
+      expectInPlace = !tree.broken;
+      break;
+    case Edit::BlurSize:
+      tree.blurSize = other(tree.blurSize, 1, 16);
+      expectInPlace = !tree.broken;
+      break;
+    case Edit::Sensitivity:
+      tree.sensitivity =
+          other(static_cast<int>(std::lround(tree.sensitivity * 10)), -10, 10) /
+          10.0;
+      expectInPlace = !tree.broken;
+      break;
+    case Edit::VfrFromBase:
+      tree.vfrFromBase = !tree.vfrFromBase;
+      expectInPlace = !tree.broken;
+      break;
+    case Edit::Accent:
+      // b.conf expanded the old value
+      tree.accent ^= 1u << std::uniform_int_distribution<int>(0, 23)(random);
+      expectInPlace = false;
+      break;
+    case Edit::DimKey:
+      tree.dim = !tree.dim;
+      expectInPlace = false;
+      break;
+    case Edit::Binds:
+      tree.bindKey = static_cast<char>('A' + other(tree.bindKey - 'A', 0, 25));
+      // Outside the tree while no source= line names it
+      if (tree.sourceBinds)
+        expectInPlace = false;
+      break;
+    case Edit::SourceLine:
+      tree.sourceBinds = !tree.sourceBinds;
+      expectInPlace = false;
+      break;
+    case Edit::Base:
+      tree.base = other(tree.base, 0, 9);
+      expectInPlace = false;
+      break;
+    case Edit::Gaps:
+      tree.gaps = other(tree.gaps, 0, 30);
+      expectInPlace = false;
+      break;
+    case Edit::Broken:
+      tree.broken = !tree.broken;
+      expectInPlace = false;
+      break;
+    case Edit::Count:
+      break;
+    }
+    tree.write(dir);
+
+    bool reparsed = engine->reparseChanged();
+    if (expectInPlace && *expectInPlace != reparsed) {
+      std::cerr << "step " << step << " (seed " << SEED << "): edit "
+                << int(edit) << " was "
+                << (reparsed ? "parsed in place" : "a full parse")
+                << std::endl;
+      ++g_failures;
+    }
+    if (reparsed) {
+      ++inPlace;
+    } else {
+      ++full;
+      engine = build(options, queries);
+    }
+    std::string expected = answers(*build(options, queries), queries);
+    std::string actual = answers(*engine, queries);
+    if (actual != expected) {
+      std::cerr << "step " << step << " (seed " << SEED << "), edit "
+                << int(edit) << (reparsed ? " in place" : " full") << ":\n"
+                << actual << "but a fresh parse gives\n"
+                << expected << std::endl;
+      ++g_failures;
+    }
+  }
+  CHECK(inPlace > 0);
+  CHECK(full > 0);
+  std::cout << inPlace << " edits parsed in place, " << full
+            << " with a full parse" << std::endl;
+  return finish("reparse");
+}
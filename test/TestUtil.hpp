@@ -0,0 +1,101 @@
+// Helpers shared by the test executables: scratch config trees and
+// failure reporting, without a test framework. Each executable exits
+// nonzero when a check failed, which ctest reports.
+#pragma once
+
+#include "ConfigUtils.hpp"
+#include "Value.hpp"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hyprquery::test {
+
+inline int g_failures = 0;
+
+#define CHECK(condition)                                                      \
+  do {                                                                        \
+    if (!(condition)) {                                                       \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition       \
+                << ") failed" << std::endl;                                   \
+      ++::hyprquery::test::g_failures;                                        \
+    }                                                                         \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                            \
+  do {                                                                        \
+    const auto &actualValue = (actual);                                       \
+    const auto &expectedValue = (expected);                                   \
+    if (!(actualValue == expectedValue)) {                                    \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #actual " is\n"        \
+                << actualValue << "\nbut expected\n"                          \
+                << expectedValue << std::endl;                                \
+      ++::hyprquery::test::g_failures;                                        \
+    }                                                                         \
+  } while (0)
+
+// A directory under $TMPDIR, removed with everything in it
+class TempDir {
+public:
+  TempDir() {
+    std::string pattern =
+        (std::filesystem::temp_directory_path() / "hyq-test-XXXXXX")
+            .string();
+    if (!mkdtemp(pattern.data())) {
+      std::cerr << "mkdtemp failed" << std::endl;
+      std::exit(1);
+    }
+    m_path = std::filesystem::canonical(pattern).string();
+  }
+  ~TempDir() {
+    std::error_code ec;
+    std::filesystem::remove_all(m_path, ec);
+  }
+
+  TempDir(const TempDir &) = delete;
+  TempDir &operator=(const TempDir &) = delete;
+
+  const std::string &path() const { return m_path; }
+
+  // Replace name, relative to the directory, with text; returns its path
+  std::string write(const std::string &name, std::string_view text) const {
+    std::filesystem::path file = std::filesystem::path(m_path) / name;
+    std::filesystem::create_directories(file.parent_path());
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out << text;
+    return file.string();
+  }
+
+private:
+  std::string m_path;
+};
+
+// Results one per line as key, type and JSON value, so that a mismatch
+// prints as a readable diff and lists compare with their files and lines
+inline std::string describe(const std::vector<QueryResult> &results) {
+  std::string out;
+  for (const auto &result : results) {
+    out += result.key;
+    out += ' ';
+    out += result.type;
+    out += ' ';
+    out += toJson(result.value).dump();
+    out += '\n';
+  }
+  return out;
+}
+
+inline int finish(std::string_view name) {
+  if (g_failures == 0)
+    std::cout << name << ": all checks passed" << std::endl;
+  else
+    std::cerr << name << ": " << g_failures << " checks failed" << std::endl;
+  return g_failures == 0 ? 0 : 1;
+}
+
+} // namespace hyprquery::test